@@ -0,0 +1,601 @@
+/*
+ * ==============================================================
+ *       Filename:  kernel_bench.c
+ *
+ *    Description:  Microbenchmark of the compression engines, below
+ *                  sha_hash_update( ): the latency of a single msg
+ *                  block, the throughput of long runs of blocks
+ *                  and, for engines with a multi-lane kernel, the
+ *                  throughput of ENGINE_LANES msgs side by side.
+ *
+ *                  usage: kernel_bench [-c CPU] [-e ENGINE] [-j FILE]
+ *
+ *                  -c  pin to CPU (default: the one it starts on)
+ *                  -e  only measure ENGINE
+ *                  -j  also write the results to FILE as JSON
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  The process is pinned to one CPU, so it isn't migrated between
+ *  cores (and caches) mid-run.  Each measurement is warmed up for
+ *  BENCH_WARMUP_NS, which also sizes a sample to BENCH_SAMPLE_NS,
+ *  and samples are taken until the coefficient of variation of the
+ *  last BENCH_WINDOW of them is under BENCH_STABLE_CV, or until
+ *  BENCH_MAX_SAMPLES.  The mean of that window is reported,
+ *  together with its CV; if none settled, the steadiest window is
+ *  reported instead and marked as not stable.
+ *
+ *  Where perf_event_open(2) is allowed (see
+ *  /proc/sys/kernel/perf_event_paranoid), cycles, instructions and
+ *  branch misses are counted around the timed calls of every sample
+ *  and reported per block over the same window as the time;
+ *  elsewhere those columns read "-".
+ *
+ *  Before an engine is measured, the digests it computes over the
+ *  benchmark data (every lane, for a multi-lane kernel) are checked
+ *  against the generic engine's; if they differ, nothing is
+ *  reported and the exit status is non-zero.
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+/* sched_setaffinity( ), syscall( ) */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "sha1.h"
+#include "engine.h"
+
+
+#define BENCH_RUN_BLOCKS   256              /* blocks per call, runs */
+#define BENCH_WARMUP_NS    50000000ULL      /* 50 ms */
+#define BENCH_SAMPLE_NS    5000000ULL       /* 5 ms */
+#define BENCH_WINDOW       10               /* samples judged together */
+#define BENCH_MAX_SAMPLES  200
+#define BENCH_STABLE_CV    0.01
+
+#define NUM_COUNTERS       3                /* cycles, instr, br-miss */
+#define MAX_RESULTS        32
+
+
+/* what is measured */
+enum bench_test_e {
+    TEST_LATENCY,                 /* one block per call */
+    TEST_RUN,                     /* BENCH_RUN_BLOCKS per call */
+    TEST_LANES                    /* BENCH_RUN_BLOCKS x ENGINE_LANES */
+};
+
+struct bench_result_s {
+
+    const char *engine;
+    const char *test;
+    size_t  blocks;               /* per call, all lanes together */
+
+    double  ns_per_block;
+    double  cv;
+    int     samples;
+    int     stable;
+
+    int     counted;              /* perf counters were read */
+    double  per_block[NUM_COUNTERS];
+
+};
+
+
+/******************** GLOBAL VARIABLES *************************/
+
+static const char *test_names[] = { "latency", "run", "lanes" };
+
+static const char *counter_names[NUM_COUNTERS] = {
+    "cycles", "instructions", "branch_misses"
+};
+
+static const uint64 counter_configs[NUM_COUNTERS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+/* the group leader (cycles) is counters[0]; -1 if not permitted */
+static int counters[NUM_COUNTERS] = { -1, -1, -1 };
+
+/* msg data for every lane */
+static uint8 data[ENGINE_LANES][BENCH_RUN_BLOCKS * BLK_SIZE];
+
+/**************************************************************/
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  now_ns
+ *  Description:  Returns a monotonic time stamp in nanoseconds.
+ * ==============================================================
+ */
+static uint64
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}		/* -----  end of static function now_ns  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  open_counters
+ *  Description:  Opens the hardware counters as one group on this
+ *                thread, user space only, disabled until run_calls( )
+ *                enables them.  Leaves counters[0] at -1 and
+ *                returns the errno if the kernel won't allow it
+ *                (or the CPU, a VM say, has no such counters).
+ * ==============================================================
+ */
+static int
+open_counters(void)
+{
+    struct perf_event_attr attr;
+    int i, fd, err;
+
+    for (i = 0; i < NUM_COUNTERS; i++) {
+        memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = PERF_TYPE_HARDWARE;
+        attr.config         = counter_configs[i];
+        attr.disabled       = i == 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_GROUP;
+
+        fd = syscall(__NR_perf_event_open, &attr, 0, -1, counters[0], 0);
+
+        if (fd < 0) {
+            err = errno;
+            for (i--; i >= 0; i--) {
+                close(counters[i]);
+                counters[i] = -1;
+            }
+            return err;
+        }
+
+        counters[i] = fd;
+    }
+
+    return 0;
+}		/* -----  end of static function open_counters  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  start_counters, stop_counters
+ *  Description:  Reset and enable the group, and disable it and
+ *                store its counts in counts.  stop_counters( )
+ *                returns 0 on success or -1 if there are no
+ *                counters or they can't be read.
+ * ==============================================================
+ */
+static void
+start_counters(void)
+{
+    ioctl(counters[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(counters[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}		/* -----  end of static function start_counters  ----- */
+
+static int
+stop_counters(uint64 *counts)
+{
+    uint64 buf[1 + NUM_COUNTERS];
+    int i;
+
+    ioctl(counters[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    if (read(counters[0], buf, sizeof(buf)) != (ssize_t) sizeof(buf))
+        return -1;
+
+    for (i = 0; i < NUM_COUNTERS; i++)
+        counts[i] = buf[1 + i];
+
+    return 0;
+}		/* -----  end of static function stop_counters  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  run_calls
+ *  Description:  Makes iters calls of test to engine e and returns
+ *                the time they took, in nanoseconds.  The states
+ *                are kept across calls, so each latency call
+ *                depends on the one before it, as in a long msg.
+ *                If counts isn't NULL, the perf counters are
+ *                enabled around the calls only and their counts
+ *                stored there; *counted is cleared if they can't
+ *                be read.
+ * ==============================================================
+ */
+static uint64
+run_calls(const struct engine_s *e, enum bench_test_e test, uint64 iters,
+          uint64 *counts, int *counted)
+{
+    struct sha_hash_s  hash[ENGINE_LANES];
+    struct sha_hash_s *lanes[ENGINE_LANES];
+    const uint8       *bufs[ENGINE_LANES];
+    uint64 start, end, i;
+    int j;
+
+    for (j = 0; j < ENGINE_LANES; j++) {
+        sha_hash_init(&hash[j]);
+        lanes[j] = &hash[j];
+        bufs[j]  = data[j];
+    }
+
+    if (counts)
+        start_counters();
+
+    start = now_ns();
+
+    for (i = 0; i < iters; i++) {
+        switch (test) {
+            case TEST_LATENCY:
+                e->compress(&hash[0], data[0], 1);
+                break;
+
+            case TEST_RUN:
+                e->compress(&hash[0], data[0], BENCH_RUN_BLOCKS);
+                break;
+
+            case TEST_LANES:
+                e->compress_x4(lanes, bufs, BENCH_RUN_BLOCKS);
+                break;
+        }
+    }
+
+    end = now_ns();
+
+    if (counts && stop_counters(counts) != 0)
+        *counted = 0;
+
+    return end - start;
+}		/* -----  end of static function run_calls  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  check_engine
+ *  Description:  Hashes the benchmark data with engine e, one
+ *                lane at a time and, if it has one, through its
+ *                multi-lane kernel, and compares every state with
+ *                the generic engine's.  Returns 0 if they all
+ *                agree or -1 after saying which one didn't.
+ * ==============================================================
+ */
+static int
+check_engine(const struct engine_s *e)
+{
+    struct sha_hash_s  want[ENGINE_LANES], got[ENGINE_LANES];
+    struct sha_hash_s *lanes[ENGINE_LANES];
+    const uint8       *bufs[ENGINE_LANES];
+    int j;
+
+    for (j = 0; j < ENGINE_LANES; j++) {
+        sha_hash_init(&want[j]);
+        sha_compress_generic(&want[j], data[j], BENCH_RUN_BLOCKS);
+
+        sha_hash_init(&got[j]);
+        e->compress(&got[j], data[j], BENCH_RUN_BLOCKS);
+
+        if (memcmp(got[j].h_sub, want[j].h_sub, sizeof(want[j].h_sub)) != 0) {
+            fprintf(stderr, "engine '%s' disagrees with generic on lane %d\n",
+                    e->name, j);
+            return -1;
+        }
+    }
+
+    if (e->compress_x4 == NULL)
+        return 0;
+
+    for (j = 0; j < ENGINE_LANES; j++) {
+        sha_hash_init(&got[j]);
+        lanes[j] = &got[j];
+        bufs[j]  = data[j];
+    }
+
+    e->compress_x4(lanes, bufs, BENCH_RUN_BLOCKS);
+
+    for (j = 0; j < ENGINE_LANES; j++) {
+        if (memcmp(got[j].h_sub, want[j].h_sub, sizeof(want[j].h_sub)) != 0) {
+            fprintf(stderr, "engine '%s' disagrees with generic on lane %d "
+                            "of its multi-lane kernel\n", e->name, j);
+            return -1;
+        }
+    }
+
+    return 0;
+}		/* -----  end of static function check_engine  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  window_stats
+ *  Description:  Computes the mean and coefficient of variation
+ *                of the n values in v.
+ * ==============================================================
+ */
+static void
+window_stats(const double *v, int n, double *mean, double *cv)
+{
+    double sum = 0, sq = 0;
+    int i;
+
+    for (i = 0; i < n; i++)
+        sum += v[i];
+    *mean = sum / n;
+
+    for (i = 0; i < n; i++)
+        sq += (v[i] - *mean) * (v[i] - *mean);
+
+    *cv = n > 1 && *mean > 0 ? sqrt(sq / (n - 1)) / *mean : 0;
+}		/* -----  end of static function window_stats  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  measure
+ *  Description:  Warms up test on engine e, then samples it until
+ *                the numbers are stable, filling in r.
+ * ==============================================================
+ */
+static void
+measure(const struct engine_s *e, enum bench_test_e test,
+        struct bench_result_s *r)
+{
+    static uint64 counts[BENCH_MAX_SAMPLES][NUM_COUNTERS];
+
+    double samples[BENCH_MAX_SAMPLES];
+    double mean, cv;
+    uint64 sums[NUM_COUNTERS];
+    uint64 iters = 1, start;
+    int    n, i, j, best = 0;
+
+    r->engine  = e->name;
+    r->test    = test_names[test];
+    r->blocks  = test == TEST_LATENCY ? 1
+               : test == TEST_RUN     ? BENCH_RUN_BLOCKS
+               :                        BENCH_RUN_BLOCKS * ENGINE_LANES;
+
+    /* warm up, growing a sample until it takes BENCH_SAMPLE_NS */
+    start = now_ns();
+    while (now_ns() - start < BENCH_WARMUP_NS) {
+        if (run_calls(e, test, iters, NULL, NULL) < BENCH_SAMPLE_NS)
+            iters *= 2;
+    }
+
+    r->counted = counters[0] >= 0;
+    r->stable  = 0;
+    r->cv      = -1;
+
+    for (n = 0; n < BENCH_MAX_SAMPLES; n++) {
+        samples[n] = (double) run_calls(e, test, iters,
+                                        r->counted ? counts[n] : NULL,
+                                        &r->counted)
+                   / (iters * r->blocks);
+
+        if (n + 1 < BENCH_WINDOW)
+            continue;
+
+        window_stats(samples + n + 1 - BENCH_WINDOW, BENCH_WINDOW,
+                     &mean, &cv);
+
+        if (r->cv < 0 || cv < r->cv) {
+            r->ns_per_block = mean;
+            r->cv           = cv;
+            best            = n + 1 - BENCH_WINDOW;
+        }
+
+        if (cv < BENCH_STABLE_CV) {
+            r->stable = 1;
+            n++;
+            break;
+        }
+    }
+
+    r->samples = n;
+
+    /* the counts of the window whose time is reported */
+    for (i = 0; r->counted && i < NUM_COUNTERS; i++) {
+        sums[i] = 0;
+        for (j = best; j < best + BENCH_WINDOW; j++)
+            sums[i] += counts[j][i];
+
+        r->per_block[i] = (double) sums[i]
+                        / (BENCH_WINDOW * iters * r->blocks);
+    }
+}		/* -----  end of static function measure  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  print_table
+ *  Description:  Prints the n results in r as a table.
+ * ==============================================================
+ */
+static void
+print_table(FILE *out, const struct bench_result_s *r, int n)
+{
+    int i, j;
+
+    fprintf(out, "%-10s %-8s %6s %10s %10s %7s %4s %10s %10s %10s\n",
+            "engine", "test", "blocks", "ns/block", "MB/s", "cv%", "ok",
+            "cyc/blk", "ins/blk", "brm/blk");
+
+    for (i = 0; i < n; i++) {
+        fprintf(out, "%-10s %-8s %6lu %10.1f %10.1f %7.2f %4s",
+                r[i].engine, r[i].test, (unsigned long) r[i].blocks,
+                r[i].ns_per_block, BLK_SIZE * 1e3 / r[i].ns_per_block,
+                100 * r[i].cv, r[i].stable ? "yes" : "no");
+
+        for (j = 0; j < NUM_COUNTERS; j++) {
+            if (r[i].counted)
+                fprintf(out, " %10.1f", r[i].per_block[j]);
+            else
+                fprintf(out, " %10s", "-");
+        }
+
+        fprintf(out, "\n");
+    }
+}		/* -----  end of static function print_table  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  print_json
+ *  Description:  Prints the n results in r, measured on cpu, as a
+ *                JSON object.  Counters that couldn't be read are
+ *                null.
+ * ==============================================================
+ */
+static void
+print_json(FILE *out, int cpu, const struct bench_result_s *r, int n)
+{
+    int i, j;
+
+    fprintf(out, "{\"cpu\": %d, \"results\": [", cpu);
+
+    for (i = 0; i < n; i++) {
+        fprintf(out, "%s\n  {\"engine\": \"%s\", \"test\": \"%s\", "
+                     "\"blocks\": %lu, \"ns_per_block\": %.3f, "
+                     "\"mb_per_s\": %.3f, \"cv\": %.5f, \"samples\": %d, "
+                     "\"stable\": %s",
+                i ? "," : "", r[i].engine, r[i].test,
+                (unsigned long) r[i].blocks, r[i].ns_per_block,
+                BLK_SIZE * 1e3 / r[i].ns_per_block, r[i].cv,
+                r[i].samples, r[i].stable ? "true" : "false");
+
+        for (j = 0; j < NUM_COUNTERS; j++) {
+            if (r[i].counted)
+                fprintf(out, ", \"%s_per_block\": %.3f",
+                        counter_names[j], r[i].per_block[j]);
+            else
+                fprintf(out, ", \"%s_per_block\": null", counter_names[j]);
+        }
+
+        fprintf(out, "}");
+    }
+
+    fprintf(out, "\n]}\n");
+}		/* -----  end of static function print_json  ----- */
+
+
+
+int
+main(int argc, char *argv[])
+{
+    struct bench_result_s results[MAX_RESULTS];
+    const struct engine_s *e;
+    const char *only = NULL, *json = NULL;
+    cpu_set_t   set;
+    FILE       *out;
+    size_t      i, j;
+    int         cpu = sched_getcpu();
+    int         n = 0, opt, err;
+
+    while ((opt = getopt(argc, argv, "c:e:j:")) != -1) {
+        switch (opt) {
+            case 'c': cpu  = atoi(optarg); break;
+            case 'e': only = optarg;       break;
+            case 'j': json = optarg;       break;
+            default:
+                fprintf(stderr,
+                        "usage: kernel_bench [-c CPU] [-e ENGINE] [-j FILE]\n");
+                return EXIT_FAILURE;
+        }
+    }
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        fprintf(stderr, "couldn't pin to CPU %d\n", cpu);
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < ENGINE_LANES; i++) {
+        for (j = 0; j < sizeof(data[i]); j++)
+            data[i][j] = (uint8) (i * 131 + j * 7);
+    }
+
+    if ((err = open_counters()) != 0)
+        fprintf(stderr, "perf counters not available (%s); "
+                        "see /proc/sys/kernel/perf_event_paranoid\n",
+                strerror(err));
+
+    for (i = 0; (e = engine_at(i)) != NULL; i++) {
+        if (!e->available() || (only && strcmp(only, e->name) != 0))
+            continue;
+
+        if (check_engine(e) != 0)
+            return EXIT_FAILURE;
+
+        measure(e, TEST_LATENCY, &results[n++]);
+        measure(e, TEST_RUN, &results[n++]);
+
+        if (e->compress_x4)
+            measure(e, TEST_LANES, &results[n++]);
+    }
+
+    if (n == 0) {
+        fprintf(stderr, "no engine '%s' on this CPU\n", only ? only : "");
+        return EXIT_FAILURE;
+    }
+
+    printf("pinned to CPU %d\n", cpu);
+    print_table(stdout, results, n);
+
+    if (json) {
+        if ((out = fopen(json, "w")) == NULL) {
+            fprintf(stderr, "couldn't create file '%s'\n", json);
+            return EXIT_FAILURE;
+        }
+        print_json(out, cpu, results, n);
+        fclose(out);
+    }
+
+    return EXIT_SUCCESS;
+}
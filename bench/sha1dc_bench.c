@@ -0,0 +1,158 @@
+/*
+ * ==============================================================
+ *       Filename:  sha1dc_bench.c
+ *
+ *    Description:  Measures the cost of collision detection: hashes
+ *                  the same buffer with the generic engine and with
+ *                  the sha1dc engine and prints the throughput of
+ *                  each and the overhead of sha1dc over generic.
+ *
+ *                  usage: sha1dc_bench [MB [runs]]
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "sha1.h"
+#include "engine.h"
+
+
+#define BENCH_DEFAULT_MB    64
+#define BENCH_DEFAULT_RUNS  5
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  now_ns
+ *  Description:  Returns a monotonic time stamp in nanoseconds.
+ * ==============================================================
+ */
+static uint64
+now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}		/* -----  end of static function now_ns  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  best_time
+ *  Description:  Hashes len bytes of buf runs times with the
+ *                engine called name and returns the fastest run,
+ *                in nanoseconds, so that noise from other
+ *                processes only ever makes a run slower.  Exits
+ *                if the engine isn't available.
+ * ==============================================================
+ */
+static uint64
+best_time(const char *name, const uint8 *buf, size_t len, int runs,
+          uint8 *digest)
+{
+    struct sha_hash_s hash;
+    uint64 start, t, best = 0;
+    int i;
+
+    if (engine_select(name) != 0) {
+        fprintf(stderr, "engine '%s' is not available\n", name);
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < runs; i++) {
+        start = now_ns();
+
+        sha_hash_init(&hash);
+        sha_hash_update(&hash, buf, len);
+        sha_hash_final(&hash, digest);
+
+        t = now_ns() - start;
+        if (i == 0 || t < best)
+            best = t;
+    }
+
+    return best;
+}		/* -----  end of static function best_time  ----- */
+
+
+
+int
+main(int argc, char *argv[])
+{
+    uint8  plain[DIGEST_SIZE], hardened[DIGEST_SIZE];
+    uint64 mb   = argc > 1 ? strtoull(argv[1], NULL, 10) : BENCH_DEFAULT_MB;
+    int    runs = argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_RUNS;
+    uint64 t_plain, t_hardened, x = 88172645463325252ULL;
+    size_t len, i;
+    uint8 *buf;
+
+    if (mb == 0 || runs <= 0) {
+        fprintf(stderr, "usage: sha1dc_bench [MB [runs]]\n");
+        return EXIT_FAILURE;
+    }
+
+    len = mb * 1024 * 1024;
+    buf = malloc(len);
+
+    if (buf == NULL) {
+        fprintf(stderr, "couldn't allocate %llu MB\n", (unsigned long long) mb);
+        return EXIT_FAILURE;
+    }
+
+    /* random data, so the cheap checks fail as often as they would
+     * on real files (xorshift64) */
+    for (i = 0; i < len; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        buf[i] = (uint8) x;
+    }
+
+    t_plain    = best_time("generic", buf, len, runs, plain);
+    t_hardened = best_time("sha1dc",  buf, len, runs, hardened);
+
+    if (memcmp(plain, hardened, DIGEST_SIZE) != 0) {
+        fprintf(stderr, "digests differ between generic and sha1dc\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%-8s %10.1f MB/s\n", "generic", mb * 1e9 / t_plain);
+    printf("%-8s %10.1f MB/s\n", "sha1dc",  mb * 1e9 / t_hardened);
+    printf("overhead %10.1f %%\n",
+           100.0 * ((double) t_hardened - t_plain) / t_plain);
+    printf("detected %10llu blocks\n",
+           (unsigned long long) sha_dc_detected());
+
+    free(buf);
+
+    return EXIT_SUCCESS;
+}
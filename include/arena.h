@@ -0,0 +1,64 @@
+/*
+ * ==============================================================
+ *       Filename:  arena.h
+ *
+ *    Description:  Per-worker memory arena.  Owns cache-line
+ *                  aligned hash contexts and a large I/O buffer,
+ *                  backed by huge pages where the system has them,
+ *                  and hands the same memory out again for every
+ *                  job, so a worker that has warmed up hashes
+ *                  files without calling malloc or free.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#ifndef _ARENA_H_
+#define _ARENA_H_
+
+#include <stddef.h>
+#include "sha1.h"
+
+
+#define ARENA_ALIGN       64                  /* cache line size */
+#define ARENA_CTX_BYTES   (4 * 1024)          /* context space */
+#define ARENA_HUGE_PAGE   (2 * 1024 * 1024)   /* I/O buffers are mapped
+                                                 in multiples of this */
+
+struct arena_s {
+
+    uint8  *ctx;                  /* ARENA_CTX_BYTES, ARENA_ALIGN aligned */
+    size_t  ctx_used;             /* handed out since arena_reset( ) */
+
+    uint8  *io;                   /* I/O buffer, or NULL if none yet */
+    size_t  io_size;              /* bytes mapped at io */
+
+};
+
+
+int    arena_init(struct arena_s *a);
+void  *arena_ctx(struct arena_s *a, size_t size);
+uint8 *arena_io(struct arena_s *a, size_t size);
+void   arena_reset(struct arena_s *a);
+void   arena_free(struct arena_s *a);
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * ==============================================================
+ *       Filename:  batch.h
+ *
+ *    Description:  Hashing of long lists of (mostly small) files.
+ *                  Files are opened relative to cached directory
+ *                  descriptors without updating their access time,
+ *                  small ones are read with a single read(2) into
+ *                  a buffer reused for every file, and failures
+ *                  are reported per file instead of ending the
+ *                  run.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#ifndef _BATCH_H_
+#define _BATCH_H_
+
+#include <sys/types.h>
+#include "sha1.h"
+
+
+#define BATCH_DIR_SLOTS   64              /* directory fds kept open */
+#define BATCH_POOL_SIZE   (128 * 1024)    /* files up to this size are
+                                             read in a single call */
+
+struct batch_dir_s {
+
+    char   *path;                 /* NULL if the slot is free */
+    int     fd;
+    dev_t   dev;                  /* what fd was opened on */
+    ino_t   ino;
+
+};
+
+struct batch_s {
+
+    struct batch_dir_s dirs[BATCH_DIR_SLOTS];
+    struct batch_dir_s *last;     /* of the previous file, or NULL */
+    uint8  *pool;                 /* BATCH_POOL_SIZE bytes */
+
+};
+
+
+int  batch_init(struct batch_s *b);
+int  batch_open(struct batch_s *b, const char *path);
+int  batch_hash_file(struct batch_s *b, const char *path, uint8 *digest);
+void batch_free(struct batch_s *b);
+
+#endif
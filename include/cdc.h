@@ -0,0 +1,81 @@
+/*
+ * ==============================================================
+ *       Filename:  cdc.h
+ *
+ *    Description:  Content-defined chunking (CDC).  Splits a
+ *                  stream into variable sized chunks whose
+ *                  boundaries depend only on the content around
+ *                  them, and computes the SHA-1 msg digest of
+ *                  each chunk in the same pass over the input.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  Boundaries are found with the Gear rolling hash and the
+ *  normalized chunking of FastCDC (Xia et al., USENIX ATC '16).
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#ifndef _CDC_H_
+#define _CDC_H_
+
+#include "sha1.h"
+
+
+#define CDC_MIN_SIZE   (2 * 1024)      /* default minimum chunk size */
+#define CDC_AVG_SIZE   (8 * 1024)      /* default average chunk size */
+#define CDC_MAX_SIZE   (64 * 1024)     /* default maximum chunk size */
+#define CDC_SIZE_LIMIT (1ULL << 32)    /* largest size cdc_init( ) takes */
+
+/* called once for every chunk, in stream order */
+typedef void (*cdc_emit_fn)(uint64 offset, uint64 length,
+                            const uint8 *digest, void *arg);
+
+struct cdc_s {
+
+    uint64  min_size;             /* no boundary before this many bytes */
+    uint64  avg_size;             /* normalization point */
+    uint64  max_size;             /* forced boundary */
+
+    uint64  mask_s;               /* harder mask, used below avg_size */
+    uint64  mask_l;               /* easier mask, used above avg_size */
+
+    uint64  fp;                   /* gear fingerprint of the current chunk */
+    uint64  offset;               /* stream offset of the current chunk */
+    uint64  pos;                  /* bytes in the current chunk so far */
+
+    struct sha_hash_s hash;       /* digest of the current chunk */
+
+    cdc_emit_fn emit;
+    void   *arg;
+
+};
+
+
+int  cdc_init(struct cdc_s *cdc, uint64 min_size, uint64 avg_size,
+              uint64 max_size, cdc_emit_fn emit, void *arg);
+void cdc_update(struct cdc_s *cdc, const uint8 *buf, size_t len);
+void cdc_final(struct cdc_s *cdc);
+
+int  cdc_file(char *filename, uint64 min_size, uint64 avg_size,
+              uint64 max_size, cdc_emit_fn emit, void *arg);
+
+#endif
@@ -0,0 +1,66 @@
+/*
+ * ==============================================================
+ *       Filename:  digest.h
+ *
+ *    Description:  Pluggable digest algorithms.  Every algorithm
+ *                  is reached through the same init/update/final
+ *                  table, so several of them can be computed over
+ *                  the same input buffers in a single pass.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#ifndef _DIGEST_H_
+#define _DIGEST_H_
+
+#include <stdio.h>
+#include "sha1.h"
+#include "arena.h"
+#include "sha256.h"
+
+
+#define DIGEST_MAX_SIZE   SHA256_DIGEST_SIZE   /* largest digest */
+#define DIGEST_MAX_ALGOS  4                    /* per digest_file( ) call */
+
+struct digest_algo_s {
+
+    const char *name;             /* as given to --algo */
+    const char *tag;              /* as printed before each digest */
+    size_t      digest_size;
+    size_t      ctx_size;         /* bytes for the ctx passed below */
+
+    void (*init)(void *ctx);
+    void (*update)(void *ctx, const uint8 *buf, size_t len);
+    void (*final)(void *ctx, uint8 *digest);
+
+};
+
+
+const struct digest_algo_s *digest_find(const char *name);
+void digest_list(FILE *stream);
+
+int  digest_file(char *filename, const struct digest_algo_s **algos,
+                 int nalgos, int nthreads, struct arena_s *arena,
+                 uint8 digests[][DIGEST_MAX_SIZE]);
+
+#endif
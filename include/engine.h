@@ -0,0 +1,106 @@
+/*
+ * ==============================================================
+ *       Filename:  engine.h
+ *
+ *    Description:  Compression engines.  Each engine is an
+ *                  implementation of the SHA-1 compression
+ *                  function (what compute_hash( ) does for one
+ *                  msg block); the fastest one the CPU supports
+ *                  is picked at run time.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+
+#ifndef _ENGINE_H_
+#define _ENGINE_H_
+
+#include <stdio.h>
+#include "sha1.h"
+
+
+#define ENGINE_LANES  4           /* msgs hashed at once by compress_x4 */
+
+struct engine_s {
+
+    const char *name;
+    int         id;               /* enum stats_engine_e, for --stats */
+
+    /* returns non-zero if this CPU can run the engine */
+    int  (*available)(void);
+
+    /* compresses nblocks consecutive msg blocks into hash->h_sub */
+    void (*compress)(struct sha_hash_s *hash, const uint8 *blocks,
+                     size_t nblocks);
+
+    /* compresses nblocks blocks from each of ENGINE_LANES independent
+     * msgs, lane i from blocks[i] into hash[i]->h_sub.  NULL unless
+     * the engine has a multi-lane kernel */
+    void (*compress_x4)(struct sha_hash_s **hash, const uint8 **blocks,
+                        size_t nblocks);
+
+};
+
+
+const struct engine_s *engine_get(void);
+int  engine_select(const char *name);
+const struct engine_s *engine_at(size_t i);
+void engine_list(FILE *stream);
+
+/* the portable engine, built on compute_hash( ) in sha1.c */
+void sha_compress_generic(struct sha_hash_s *hash, const uint8 *blocks,
+                          size_t nblocks);
+
+/* hashes len bytes from each of bufs[0..ENGINE_LANES-1] into the
+ * matching fresh hash[i], using compress_x4 when there is one */
+void sha_hash_update_x4(struct sha_hash_s **hash, const uint8 **bufs,
+                        size_t len);
+
+/* the collision detecting engine in sha1dc.c: hashes like the
+ * generic one, but sets hash->collision on a block that belongs to
+ * a collision attack, and compresses it twice more (the SHA-1DC safe
+ * hash); sha_dc_detected( ) counts such blocks */
+void sha_compress_dc(struct sha_hash_s *hash, const uint8 *blocks,
+                     size_t nblocks);
+uint64 sha_dc_detected(void);
+
+/* the library build's entry point to the fastest plain kernel,
+ * bound by an IFUNC resolver when libsha1 is loaded, and the name of
+ * the engine it was bound to */
+#ifdef SHA_IFUNC
+void sha_compress_auto(struct sha_hash_s *hash, const uint8 *blocks,
+                       size_t nblocks);
+const char *sha_compress_auto_name(void);
+#endif
+
+/* kernels in sha1_arm.c; only built for aarch64 */
+#if defined(__aarch64__)
+int  sha_arm_ce_available(void);
+void sha_compress_arm_ce(struct sha_hash_s *hash, const uint8 *blocks,
+                         size_t nblocks);
+int  sha_neon_available(void);
+void sha_compress_neon_x4(struct sha_hash_s **hash, const uint8 **blocks,
+                          size_t nblocks);
+#endif
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * ==============================================================
+ *       Filename:  git.h
+ *
+ *    Description:  Git object IDs.  Git names an object by the
+ *                  SHA-1 msg digest of "<type> <size>\0" followed
+ *                  by the object's content; for a file that is
+ *                  the blob "blob <size>\0<file contents>".
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#ifndef _GIT_H_
+#define _GIT_H_
+
+#include "sha1.h"
+
+
+#define GIT_TYPE_BLOB    "blob"
+#define GIT_TYPE_TREE    "tree"
+#define GIT_TYPE_COMMIT  "commit"
+#define GIT_TYPE_TAG     "tag"
+
+
+int git_object_init(struct sha_hash_s *hash, const char *type, uint64 length);
+int git_hash_file(char *filename, const char *type, uint8 *digest);
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * ==============================================================
+ *       Filename:  incr.h
+ *
+ *    Description:  Incremental hashing of append-only files.  The
+ *                  intermediate SHA-1 state after the last byte
+ *                  hashed is kept in a state file next to the
+ *                  file, so the next run only hashes what has been
+ *                  appended since.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#ifndef _INCR_H_
+#define _INCR_H_
+
+#include "sha1.h"
+
+
+#define INCR_SUFFIX     ".sha1state"      /* state file = file + this */
+#define INCR_TAIL_SIZE  4096              /* bytes re-read at each end to
+                                             check that the hashed prefix
+                                             is intact */
+
+/* how incr_hash_file( ) got the digest */
+enum incr_result_e {
+    INCR_FAILED = -1,
+    INCR_FULL,                    /* no usable state: hashed it all */
+    INCR_APPENDED                 /* hashed only the appended bytes */
+};
+
+
+int incr_hash_file(const char *filename, uint8 *digest, int *collision);
+
+#endif
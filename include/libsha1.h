@@ -0,0 +1,69 @@
+/*
+ * ==============================================================
+ *       Filename:  libsha1.h
+ *
+ *    Description:  Public interface of libsha1, the shared and
+ *                  static library build of this program's SHA-1
+ *                  code.  Only what is declared here is exported;
+ *                  the context is opaque, so its layout can change
+ *                  without breaking callers built against an older
+ *                  version of the library.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#ifndef _LIBSHA1_H_
+#define _LIBSHA1_H_
+
+#include <stddef.h>
+
+
+/* marks the exported functions; everything else in the library is
+ * built with -fvisibility=hidden */
+#if defined(__GNUC__)
+#define SHA_API  __attribute__((visibility("default")))
+#else
+#define SHA_API
+#endif
+
+#define SHA1_ABI_VERSION  1           /* bumped with the soname */
+#define SHA1_DIGEST_SIZE  20
+
+/* a msg being hashed; only ever handled through a pointer */
+typedef struct sha1_ctx sha1_ctx;
+
+
+SHA_API unsigned int sha1_abi_version(void);
+SHA_API const char  *sha1_engine(void);
+
+SHA_API sha1_ctx *sha1_new(void);
+SHA_API void      sha1_free(sha1_ctx *ctx);
+SHA_API void      sha1_reset(sha1_ctx *ctx);
+SHA_API void      sha1_update(sha1_ctx *ctx, const void *buf, size_t len);
+SHA_API void      sha1_final(sha1_ctx *ctx, unsigned char *digest);
+
+SHA_API void      sha1_digest(const void *buf, size_t len,
+                              unsigned char *digest);
+SHA_API int       sha1_file(const char *path, unsigned char *digest);
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * ==============================================================
+ *       Filename:  piece.h
+ *
+ *    Description:  Fixed size piece hashing, as used for
+ *                  BitTorrent style piece lists.  Computes the
+ *                  SHA-1 msg digest of every piece of a file and
+ *                  of the whole file from a single read of it,
+ *                  hashing the pieces in parallel.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#ifndef _PIECE_H_
+#define _PIECE_H_
+
+#include "sha1.h"
+
+
+#define PIECE_MIN_SIZE      (16 * 1024)
+#define PIECE_MAX_SIZE      (16 * 1024 * 1024)
+#define PIECE_DEFAULT_SIZE  (256 * 1024)
+
+struct piece_list_s {
+
+    uint64  piece_size;           /* bytes per piece (the last may be short) */
+    uint64  length;               /* bytes in the whole file */
+    uint64  count;                /* number of pieces */
+
+    uint8  *digests;              /* count * DIGEST_SIZE bytes, in order */
+    uint8   whole[DIGEST_SIZE];   /* digest of the whole file */
+
+};
+
+
+int  piece_hash_file(char *filename, uint64 piece_size, int nthreads,
+                     struct piece_list_s *list);
+void piece_list_free(struct piece_list_s *list);
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * ==============================================================
+ *       Filename:  pipeline.h
+ *
+ *    Description:  Overlapped reading and hashing of a pipe.  A
+ *                  reader thread fills a ring of large buffers
+ *                  from the input while the calling thread works
+ *                  on the previous one, so neither waits for the
+ *                  other as long as a buffer is free.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include <sys/types.h>
+#include <pthread.h>
+#include "sha1.h"
+
+
+#define PIPELINE_BUFS      3                  /* buffers in the ring */
+#define PIPELINE_BUF_SIZE  (1024 * 1024)      /* bytes per buffer */
+#define PIPELINE_SIZE      (PIPELINE_BUFS * PIPELINE_BUF_SIZE)
+
+struct pipeline_s {
+
+    int      fd;                          /* input being read */
+    uint8   *data;                        /* PIPELINE_BUFS buffers */
+    int      owned;                       /* data was allocated here */
+    size_t   len[PIPELINE_BUFS];          /* bytes filled in each */
+
+    /* buffers filled so far (by the reader) and handed back (by the
+     * consumer); the buffer in use is taken % PIPELINE_BUFS */
+    uint64   filled;
+    uint64   taken;
+    int      holding;                     /* consumer has a buffer out */
+
+    int      done;                        /* reader hit end of input... */
+    int      error;                       /* ...or this read error (errno) */
+    int      stop;                        /* consumer gave up early */
+    int      wake[2];                     /* pipe that wakes the reader */
+
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    pthread_t       reader;
+
+};
+
+
+int     pipeline_start(struct pipeline_s *pl, int fd, uint8 *data);
+ssize_t pipeline_next(struct pipeline_s *pl, const uint8 **buf);
+void    pipeline_finish(struct pipeline_s *pl);
+
+void    pipeline_grow_pipe(int fd);
+
+#endif
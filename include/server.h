@@ -0,0 +1,84 @@
+/*
+ * ==============================================================
+ *       Filename:  server.h
+ *
+ *    Description:  Long running hashing daemon.  Listens on a
+ *                  local Unix domain socket and answers path or
+ *                  inline buffer requests with their SHA-1 msg
+ *                  digests, keeping its worker threads, buffers
+ *                  and a digest cache warm between requests.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+#include <stddef.h>
+#include "sha1.h"
+
+
+/*
+ * Wire format.  All integers are unsigned and big-endian.
+ *
+ *   request:  u32 length | u32 id | u8 type   | payload
+ *   reply:    u32 length | u32 id | u8 status | payload
+ *
+ * length counts everything after itself.  A request's payload is a
+ * path (REQ_PATH, not '\0' terminated) or the data to hash
+ * (REQ_BUF).  A reply's payload is the DIGEST_SIZE byte digest
+ * (REPLY_OK) or an error message (REPLY_ERR).  Requests on one
+ * connection may be pipelined; replies come back as they complete,
+ * not necessarily in order, and carry the id of their request.
+ */
+#define REQ_PATH    'P'
+#define REQ_BUF     'B'
+
+#define REPLY_OK    0
+#define REPLY_ERR   1
+
+#define SERVER_MAX_FRAME   (64 * 1024 * 1024)  /* largest request accepted */
+#define SERVER_BATCH       16                  /* jobs taken per queue lock */
+#define SERVER_CACHE_SIZE  4096                /* digest cache slots */
+
+/* how far one connection may get ahead of the workers: once this
+ * many of its requests, or payload bytes, are waiting, its reader
+ * stops reading until some are done.  SERVER_CONN_BYTES must be at
+ * least SERVER_MAX_FRAME */
+#define SERVER_CONN_JOBS   64
+#define SERVER_CONN_BYTES  (2 * SERVER_MAX_FRAME)
+
+/* how long, in ms, a reply may wait for room in a client's socket
+ * buffer; a client that reads none of its replies for that long is
+ * disconnected */
+#define SERVER_SEND_WAIT   1000
+
+
+int server_run(const char *sock_path, int nthreads);
+
+int server_connect(const char *sock_path);
+int server_request(int fd, uint32 id, int type, const void *payload,
+                   uint32 len, uint8 *digest, char *err, size_t err_len);
+
+#endif
@@ -47,10 +47,15 @@
 #define _SECHASH_H_
 
 
+#include <stddef.h>
+
 #define BLK_SIZE     64
+#define DIGEST_SIZE  20           /* bytes in a raw 160-bit digest */
+#define HEX_SIZE     41           /* 40 hex chars plus the '\0' */
 
-typedef unsigned char uint8;
-typedef unsigned int  uint32;
+typedef unsigned char      uint8;
+typedef unsigned int       uint32;
+typedef unsigned long long uint64;
 
 struct sha_hash_s {
 
@@ -62,6 +67,9 @@ struct sha_hash_s {
 
     uint32  h_sub[5];             /* from spec: H[0], ..., H[4] */
 
+    uint8   collision;            /* set by the sha1dc engine if a block
+                                     is part of a collision attack */
+
 };
 
 
@@ -71,4 +79,14 @@ char * sha_hash_str(char *str);
 
 void sha_hash_file_output(char *file);
 
+/* incremental interface; unlike the calls above these keep no
+ * global state, so each caller owns its struct sha_hash_s */
+void sha_hash_init(struct sha_hash_s *hash);
+void sha_hash_update(struct sha_hash_s *hash, const uint8 *buf, size_t len);
+long long sha_hash_update_fd(struct sha_hash_s *hash, int fd);
+long long sha_hash_update_fd_buf(struct sha_hash_s *hash, int fd, uint8 *buf,
+                                 size_t size);
+void sha_hash_final(struct sha_hash_s *hash, uint8 *digest);
+void sha_hash_hex(const uint8 *digest, char *hex);
+
 #endif
@@ -0,0 +1,54 @@
+/*
+ * ==============================================================
+ *       Filename:  sha256.h
+ *
+ *    Description:  SHA-256, as specified in FIPS 180-4, with the
+ *                  same incremental init/update/final interface as
+ *                  the SHA-1 implementation.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#ifndef _SHA256_H_
+#define _SHA256_H_
+
+#include "sha1.h"
+
+
+#define SHA256_DIGEST_SIZE  32
+
+struct sha256_s {
+
+    uint8   msg_block[BLK_SIZE];  /* partial msg block */
+    int     msg_idx;              /* bytes in msg_block */
+    uint64  length;               /* msg length so far, in bytes */
+    uint32  h_sub[8];             /* intermediate hash value */
+
+};
+
+
+void sha256_init(struct sha256_s *hash);
+void sha256_update(struct sha256_s *hash, const uint8 *buf, size_t len);
+void sha256_final(struct sha256_s *hash, uint8 *digest);
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * ==============================================================
+ *       Filename:  stats.h
+ *
+ *    Description:  Hot path instrumentation.  Counters and per
+ *                  stage timers for the hashing code, compiled in
+ *                  but reduced to a single predictable branch
+ *                  each when they are turned off.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+
+#ifndef _STATS_H_
+#define _STATS_H_
+
+#include <stdio.h>
+#include <sys/types.h>
+#include "sha1.h"
+
+
+/* where the time goes */
+enum stats_stage_e {
+    STAGE_IO,             /* waiting in read(2) */
+    STAGE_COMPRESS,       /* compressing msg blocks */
+    STAGE_OUTPUT,         /* printing the results */
+    STAGE_MAX
+};
+
+/* compression function implementations */
+enum stats_engine_e {
+    ENGINE_GENERIC,       /* the portable compute_hash( ) */
+    ENGINE_ARMV8_CE,      /* ARMv8 SHA1 crypto extension instructions */
+    ENGINE_NEON,          /* 4 lane NEON kernel */
+    ENGINE_SHA1DC,        /* generic, with collision attack detection */
+    ENGINE_MAX
+};
+
+struct stats_s {
+
+    uint64  blocks;                     /* msg blocks compressed */
+    uint64  bytes_read;                 /* bytes returned by read(2) */
+    uint64  read_calls;                 /* read(2) system calls */
+    uint64  engine_bytes[ENGINE_MAX];   /* bytes compressed per engine */
+    uint64  stage_ns[STAGE_MAX];        /* nanoseconds per stage, summed
+                                           over all threads */
+
+};
+
+extern int            sha_stats_enabled;
+extern struct stats_s sha_stats;
+
+
+/* when stats are off these cost one test of sha_stats_enabled each */
+#define STATS_ADD(field, n)                                             \
+    do {                                                                \
+        if (sha_stats_enabled)                                          \
+            __atomic_fetch_add(&sha_stats.field, (n), __ATOMIC_RELAXED); \
+    } while (0)
+
+#define STATS_CLOCK()  (sha_stats_enabled ? stats_now() : 0)
+
+
+void    stats_enable(void);
+uint64  stats_now(void);
+ssize_t stats_read(int fd, void *buf, size_t len);
+void    stats_print_json(FILE *stream);
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * ==============================================================
+ *       Filename:  tee.h
+ *
+ *    Description:  Pass-through hashing: copies an input to an
+ *                  output and computes the SHA-1 msg digest of the
+ *                  bytes on the way, from the same buffers, so the
+ *                  data is only read once.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#ifndef _TEE_H_
+#define _TEE_H_
+
+#include "sha1.h"
+
+
+int tee_file(char *src, char *dst, uint8 *digest);
+
+#endif
@@ -0,0 +1,300 @@
+/*
+ * ==============================================================
+ *       Filename:  batch.c
+ *
+ *    Description:  Hashing of long lists of (mostly small) files.
+ *                  Files are opened relative to cached directory
+ *                  descriptors without updating their access time,
+ *                  small ones are read with a single read(2) into
+ *                  a buffer reused for every file, and failures
+ *                  are reported per file instead of ending the
+ *                  run.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  With 100k+ small files, the per-file cost is almost all system
+ *  calls: resolving the whole path on every open, the access time
+ *  update, and the stdio buffering and extra read(2) that confirms
+ *  EOF.  Caching the directory descriptors lets the kernel resolve
+ *  only the last component, and a file whose size fstat(2) already
+ *  gave is done after one read(2).
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+/* O_NOATIME */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "batch.h"
+#include "stats.h"
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  dir_slot
+ *  Description:  Returns the cache slot for the directory given
+ *                by the first len bytes of path (FNV-1a).
+ * ==============================================================
+ */
+static int
+dir_slot(const char *path, size_t len)
+{
+    uint32 h = 2166136261U;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        h ^= (uint8) path[i];
+        h *= 16777619U;
+    }
+
+    return h % BATCH_DIR_SLOTS;
+}		/* -----  end of static function dir_slot  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  dir_fd
+ *  Description:  Returns a descriptor for the directory given by
+ *                the first len bytes of path, opening it if it
+ *                isn't cached.  When the run moves on to another
+ *                cached directory, its descriptor is only reused if
+ *                the path still names the directory it was opened
+ *                on (same device and inode), so a directory renamed
+ *                or replaced since is opened again.  Files in a row
+ *                from the same directory aren't checked, which
+ *                would cost as much as opening them by their full
+ *                path: like fts(3), a directory replaced while its
+ *                files are being read goes unnoticed.  A directory
+ *                evicted from its slot is closed.  Returns -1 if the directory can't be
+ *                opened; the caller then falls back to the full
+ *                path, which reports the real error.
+ * ==============================================================
+ */
+static int
+dir_fd(struct batch_s *b, const char *path, size_t len)
+{
+    struct batch_dir_s *d = &b->dirs[dir_slot(path, len)];
+    struct stat st;
+    char  *copy;
+    int    fd;
+
+    if (d->path && strncmp(d->path, path, len) == 0 && d->path[len] == '\0'
+            && (d == b->last || (stat(d->path, &st) == 0
+                                 && st.st_dev == d->dev
+                                 && st.st_ino == d->ino))) {
+        b->last = d;
+        return d->fd;
+    }
+
+    if ((copy = malloc(len + 1)) == NULL)
+        return -1;
+
+    memcpy(copy, path, len);
+    copy[len] = '\0';
+
+    fd = open(copy, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0)
+            close(fd);
+        free(copy);
+        return -1;
+    }
+
+    if (d->path) {
+        close(d->fd);
+        free(d->path);
+    }
+
+    d->path = copy;
+    d->fd   = fd;
+    d->dev  = st.st_dev;
+    d->ino  = st.st_ino;
+    b->last = d;
+
+    return fd;
+}		/* -----  end of static function dir_fd  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  batch_init
+ *  Description:  Prepares b for a run of batch_open( ) and
+ *                batch_hash_file( ) calls.  Returns 0 on success
+ *                or -1 if the buffer can't be allocated.
+ * ==============================================================
+ */
+int
+batch_init(struct batch_s *b)
+{
+    int i;
+
+    for (i = 0; i < BATCH_DIR_SLOTS; i++) {
+        b->dirs[i].path = NULL;
+        b->dirs[i].fd   = -1;
+    }
+
+    b->last = NULL;
+    b->pool = malloc(BATCH_POOL_SIZE);
+
+    return b->pool ? 0 : -1;
+}		/* -----  end of function batch_init  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  batch_open
+ *  Description:  Opens path for reading with openat(2), relative
+ *                to the cached descriptor of its directory, and
+ *                with O_NOATIME.  O_NOATIME is only allowed on
+ *                files the caller owns, so on EPERM the open is
+ *                retried without it.  Returns the descriptor, or
+ *                -1 with errno set.
+ * ==============================================================
+ */
+int
+batch_open(struct batch_s *b, const char *path)
+{
+    const char *base  = path;
+    const char *slash = strrchr(path, '/');
+    int dirfd = AT_FDCWD;
+    int fd;
+
+    /* a trailing slash is left for open to complain about */
+    if (slash && slash[1] != '\0') {
+        dirfd = dir_fd(b, path, slash == path ? 1 : (size_t) (slash - path));
+
+        if (dirfd < 0) {
+            dirfd   = AT_FDCWD;
+            b->last = NULL;
+        } else {
+            base = slash + 1;
+        }
+    } else {
+        b->last = NULL;
+    }
+
+    fd = openat(dirfd, base, O_RDONLY | O_NOATIME | O_CLOEXEC);
+
+    if (fd < 0 && errno == EPERM)
+        fd = openat(dirfd, base, O_RDONLY | O_CLOEXEC);
+
+    return fd;
+}		/* -----  end of function batch_open  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  batch_hash_file
+ *  Description:  Computes the msg digest of the file given by
+ *                path into digest (DIGEST_SIZE bytes).  A regular
+ *                file of at most BATCH_POOL_SIZE bytes is read
+ *                with one read(2) into the pool; anything else,
+ *                or a file whose read doesn't match the size
+ *                fstat(2) gave, is streamed (on) by
+ *                sha_hash_update_fd( ).
+ *
+ *                Returns 0 on success, or -1 after printing the
+ *                reason to stderr; unlike sha_hash_file( ), it
+ *                never exits, so a bad file doesn't end a batch.
+ * ==============================================================
+ */
+int
+batch_hash_file(struct batch_s *b, const char *path, uint8 *digest)
+{
+    struct sha_hash_s hash;
+    struct stat st;
+    ssize_t n = -1;
+    int fd;
+
+    fd = batch_open(b, path);
+
+    if (fd < 0) {
+        fprintf(stderr, "couldn't open file '%s': %s\n", path,
+                strerror(errno));
+        return -1;
+    }
+
+    sha_hash_init(&hash);
+
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)
+            && st.st_size <= BATCH_POOL_SIZE) {
+        n = stats_read(fd, b->pool, BATCH_POOL_SIZE);
+
+        if (n < 0)
+            goto fail;
+
+        sha_hash_update(&hash, b->pool, n);
+    }
+
+    /* when all of the size fstat gave came in, there is no need for
+     * another read to see EOF */
+    if ((n < 0 || n != st.st_size) && sha_hash_update_fd(&hash, fd) < 0)
+        goto fail;
+
+    sha_hash_final(&hash, digest);
+    close(fd);
+
+    return 0;
+
+fail:
+    fprintf(stderr, "error reading '%s': %s\n", path, strerror(errno));
+    close(fd);
+
+    return -1;
+}		/* -----  end of function batch_hash_file  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  batch_free
+ *  Description:  Closes the cached directories and frees the pool.
+ * ==============================================================
+ */
+void
+batch_free(struct batch_s *b)
+{
+    int i;
+
+    for (i = 0; i < BATCH_DIR_SLOTS; i++) {
+        if (b->dirs[i].path) {
+            close(b->dirs[i].fd);
+            free(b->dirs[i].path);
+            b->dirs[i].path = NULL;
+        }
+    }
+
+    free(b->pool);
+    b->pool = NULL;
+}		/* -----  end of function batch_free  ----- */
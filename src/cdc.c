@@ -0,0 +1,355 @@
+/*
+ * ==============================================================
+ *       Filename:  cdc.c
+ *
+ *    Description:  Content-defined chunking (CDC).  Splits a
+ *                  stream into variable sized chunks whose
+ *                  boundaries depend only on the content around
+ *                  them, and computes the SHA-1 msg digest of
+ *                  each chunk in the same pass over the input.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  Boundaries are found with the Gear rolling hash and the
+ *  normalized chunking of FastCDC (Xia et al., USENIX ATC '16).
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "cdc.h"
+#include "stats.h"
+
+
+/* size of the buffer handed to cdc_update( ) by cdc_file( ) */
+#define CDC_BUF_SIZE  (64 * 1024)
+
+/* FastCDC normalization level: mask_s has this many more bits
+ * than log2(avg_size), mask_l this many fewer */
+#define CDC_NORMAL_LEVEL  2
+
+
+/******************** GLOBAL VARIABLES *************************/
+
+/* Gear table, one random 64-bit value per byte value.  Chunk
+ * boundaries (and therefore dedup hits against previously stored
+ * chunks) depend on these values, so the seed must never change. */
+static uint64 gear[256];
+static int    gear_ready = 0;
+
+/**************************************************************/
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  splitmix64
+ *  Description:  Returns the next value of the splitmix64
+ *                generator whose state is pointed to by x.  Only
+ *                used to fill the gear table.
+ * ==============================================================
+ */
+static uint64
+splitmix64(uint64 *x)
+{
+    uint64 z = (*x += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}		/* -----  end of static function splitmix64  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  init_gear
+ *  Description:  Fills the gear table from a fixed seed the
+ *                first time it is called.
+ * ==============================================================
+ */
+static void
+init_gear(void)
+{
+    uint64 seed = 0x5348413143444321ULL;    /* "SHA1CDC!" */
+    int i;
+
+    if (gear_ready)
+        return;
+
+    for (i = 0; i < 256; i++)
+        gear[i] = splitmix64(&seed);
+
+    gear_ready = 1;
+}		/* -----  end of static function init_gear  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  top_mask
+ *  Description:  Returns a mask with the n most significant bits
+ *                set.  The gear fingerprint is shifted left once
+ *                per byte, so its top bits depend on the last 64
+ *                bytes while its low bits only depend on the last
+ *                few; testing the top bits gives the rolling hash
+ *                its full 64 byte window.
+ * ==============================================================
+ */
+static uint64
+top_mask(int n)
+{
+    if (n <= 0)
+        return 0;
+
+    return ~0ULL << (64 - n);
+}		/* -----  end of static function top_mask  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  emit_chunk
+ *  Description:  Finishes the digest of the current chunk, hands
+ *                it to the emit callback and starts a new chunk
+ *                at the following byte.
+ * ==============================================================
+ */
+static void
+emit_chunk(struct cdc_s *cdc)
+{
+    uint8 digest[DIGEST_SIZE];
+
+    sha_hash_final(&cdc->hash, digest);
+    cdc->emit(cdc->offset, cdc->pos, digest, cdc->arg);
+
+    cdc->offset += cdc->pos;
+    cdc->pos = 0;
+    cdc->fp  = 0;
+    sha_hash_init(&cdc->hash);
+}		/* -----  end of static function emit_chunk  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  cdc_init
+ *  Description:  Prepares cdc to chunk a new stream.  Chunks will
+ *                be at least min_size and at most max_size bytes
+ *                long (except for the last chunk, which may be
+ *                shorter), averaging roughly avg_size bytes.
+ *                emit is called with arg for every chunk.
+ *
+ *                Returns 0 on success or -1 if the sizes do not
+ *                satisfy 0 < min_size <= avg_size <= max_size <=
+ *                CDC_SIZE_LIMIT.  The limit keeps the masks, which
+ *                take a few bits more than avg_size has, within
+ *                the 64 bit fingerprint.
+ * ==============================================================
+ */
+int
+cdc_init(struct cdc_s *cdc, uint64 min_size, uint64 avg_size,
+         uint64 max_size, cdc_emit_fn emit, void *arg)
+{
+    int bits = 0;
+
+    if (min_size == 0 || min_size > avg_size || avg_size > max_size
+            || max_size > CDC_SIZE_LIMIT)
+        return -1;
+
+    init_gear();
+
+    /* bits = floor(log2(avg_size)) */
+    while ((avg_size >> (bits + 1)) != 0)
+        bits++;
+
+    cdc->min_size = min_size;
+    cdc->avg_size = avg_size;
+    cdc->max_size = max_size;
+
+    cdc->mask_s = top_mask(bits + CDC_NORMAL_LEVEL);
+    cdc->mask_l = top_mask(bits - CDC_NORMAL_LEVEL);
+
+    cdc->fp     = 0;
+    cdc->offset = 0;
+    cdc->pos    = 0;
+    sha_hash_init(&cdc->hash);
+
+    cdc->emit = emit;
+    cdc->arg  = arg;
+
+    return 0;
+}		/* -----  end of function cdc_init  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  cdc_update
+ *  Description:  Adds len bytes, pointed to by buf, to the
+ *                stream.  The boundary scan and the digest of the
+ *                current chunk are done in the same walk over
+ *                buf: the bytes of a chunk are fed to
+ *                sha_hash_update( ) straight out of buf (no copy)
+ *                as soon as its boundary is found, while they are
+ *                still in cache, and any bytes left over at the
+ *                end of buf are fed before returning.
+ *
+ *                As in FastCDC, the first min_size bytes of a
+ *                chunk are skipped by the scan, the harder mask
+ *                is used up to avg_size and the easier one after
+ *                it.  The byte that completes a boundary is the
+ *                last byte of its chunk.
+ * ==============================================================
+ */
+void
+cdc_update(struct cdc_s *cdc, const uint8 *buf, size_t len)
+{
+    const uint8 *start = buf;          /* first byte not yet hashed */
+    const uint8 *end   = buf + len;
+    uint64 skip;
+
+    while (buf < end) {
+
+        /* no boundary can occur before min_size */
+        if (cdc->pos < cdc->min_size) {
+            skip = cdc->min_size - cdc->pos;
+            if (skip > (uint64) (end - buf))
+                skip = end - buf;
+
+            buf      += skip;
+            cdc->pos += skip;
+            continue;
+        }
+
+        /* only reached when min_size == max_size: the chunk is
+         * already full, so it ends before this byte */
+        if (cdc->pos >= cdc->max_size) {
+            sha_hash_update(&cdc->hash, start, buf - start);
+            start = buf;
+
+            emit_chunk(cdc);
+            continue;
+        }
+
+        cdc->fp = (cdc->fp << 1) + gear[*buf++];
+        cdc->pos++;
+
+        if ((cdc->fp & (cdc->pos <= cdc->avg_size ? cdc->mask_s
+                                                  : cdc->mask_l)) == 0
+                || cdc->pos >= cdc->max_size) {
+
+            sha_hash_update(&cdc->hash, start, buf - start);
+            start = buf;
+
+            emit_chunk(cdc);
+        }
+    }
+
+    sha_hash_update(&cdc->hash, start, end - start);
+
+}		/* -----  end of function cdc_update  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  cdc_final
+ *  Description:  Ends the stream, emitting whatever is left as
+ *                the last chunk.  An empty stream produces no
+ *                chunks.
+ * ==============================================================
+ */
+void
+cdc_final(struct cdc_s *cdc)
+{
+    if (cdc->pos > 0)
+        emit_chunk(cdc);
+}		/* -----  end of function cdc_final  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  cdc_file
+ *  Description:  API function to chunk the file given by
+ *                filename (or stdin if filename is NULL),
+ *                calling emit with arg for every chunk.  Returns 0
+ *                on success, or -1 if the chunk sizes are invalid
+ *                or the file can't be read, after printing the
+ *                reason to stderr.
+ * ==============================================================
+ */
+int
+cdc_file(char *filename, uint64 min_size, uint64 avg_size,
+         uint64 max_size, cdc_emit_fn emit, void *arg)
+{
+    uint8   buf[CDC_BUF_SIZE];
+
+    struct cdc_s cdc;
+    int     fd;
+    ssize_t n;
+
+    if (cdc_init(&cdc, min_size, avg_size, max_size, emit, arg) != 0) {
+        fprintf(stderr, "invalid chunk sizes: need 0 < min <= avg <= max "
+                        "<= 4G\n");
+        return -1;
+    }
+
+    if (filename) {
+
+        fd = open(filename, O_RDONLY);
+
+        if (fd < 0) {
+            fprintf(stderr, "couldn't open file '%s'\n", filename);
+            return -1;
+        }
+
+    } else {
+
+        fd = STDIN_FILENO;
+    }
+
+    while ((n = stats_read(fd, buf, sizeof(buf))) > 0) {
+        cdc_update(&cdc, buf, n);
+    }
+
+    if (n < 0) {
+        fprintf(stderr, "error reading '%s'\n", filename ? filename : "-");
+        close(fd);
+        return -1;
+    }
+
+    cdc_final(&cdc);
+
+    if (close(fd) != 0) {
+        fprintf(stderr, "couldn't close file '%s'\n", filename);
+        return -1;
+    }
+
+    return 0;
+}		/* -----  end of function cdc_file  ----- */
@@ -0,0 +1,426 @@
+/*
+ * ==============================================================
+ *       Filename:  digest.c
+ *
+ *    Description:  Pluggable digest algorithms.  Every algorithm
+ *                  is reached through the same init/update/final
+ *                  table, so several of them can be computed over
+ *                  the same input buffers in a single pass.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "digest.h"
+#include "pipeline.h"
+#include "stats.h"
+
+
+/* when the algorithms take turns on a buffer, they do so a slice
+ * at a time, so each slice is still in cache for the next one */
+#define DIGEST_SLICE  (64 * 1024)
+
+
+/* a buffer handed from the reading thread to the hashing threads */
+struct digest_job_s {
+
+    const uint8    *buf;
+    ssize_t         len;          /* 0 tells the threads to stop */
+    uint64          gen;          /* bumped for every new buffer */
+    int             pending;      /* threads still hashing buf */
+
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+
+};
+
+/* one hashing thread per extra algorithm */
+struct digest_worker_s {
+
+    struct digest_job_s        *job;
+    const struct digest_algo_s *algo;
+    void                       *ctx;
+    pthread_t                   thread;
+
+};
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha1_init, sha1_update, sha1_final
+ *  Description:  The SHA-1 API behind the generic interface.
+ * ==============================================================
+ */
+static void
+sha1_init(void *ctx)
+{
+    sha_hash_init(ctx);
+}		/* -----  end of static function sha1_init  ----- */
+
+static void
+sha1_update(void *ctx, const uint8 *buf, size_t len)
+{
+    sha_hash_update(ctx, buf, len);
+}		/* -----  end of static function sha1_update  ----- */
+
+static void
+sha1_final(void *ctx, uint8 *digest)
+{
+    sha_hash_final(ctx, digest);
+}		/* -----  end of static function sha1_final  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha256_init_ctx, sha256_update_ctx,
+ *                sha256_final_ctx
+ *  Description:  The SHA-256 API behind the generic interface.
+ * ==============================================================
+ */
+static void
+sha256_init_ctx(void *ctx)
+{
+    sha256_init(ctx);
+}		/* -----  end of static function sha256_init_ctx  ----- */
+
+static void
+sha256_update_ctx(void *ctx, const uint8 *buf, size_t len)
+{
+    sha256_update(ctx, buf, len);
+}		/* -----  end of static function sha256_update_ctx  ----- */
+
+static void
+sha256_final_ctx(void *ctx, uint8 *digest)
+{
+    sha256_final(ctx, digest);
+}		/* -----  end of static function sha256_final_ctx  ----- */
+
+
+/******************** GLOBAL VARIABLES *************************/
+
+static const struct digest_algo_s algos_table[] = {
+    { "sha1",   "SHA1",   DIGEST_SIZE,        sizeof(struct sha_hash_s),
+      sha1_init, sha1_update, sha1_final },
+    { "sha256", "SHA256", SHA256_DIGEST_SIZE, sizeof(struct sha256_s),
+      sha256_init_ctx, sha256_update_ctx, sha256_final_ctx }
+};
+
+#define NUM_ALGOS  (sizeof(algos_table) / sizeof(algos_table[0]))
+
+/**************************************************************/
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  digest_find
+ *  Description:  API function to look up an algorithm by name.
+ *                Returns NULL if there is no such algorithm.
+ * ==============================================================
+ */
+const struct digest_algo_s *
+digest_find(const char *name)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_ALGOS; i++) {
+        if (strcmp(algos_table[i].name, name) == 0)
+            return &algos_table[i];
+    }
+
+    return NULL;
+}		/* -----  end of function digest_find  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  digest_list
+ *  Description:  API function to print the name of every
+ *                algorithm, one per line.
+ * ==============================================================
+ */
+void
+digest_list(FILE *stream)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_ALGOS; i++)
+        fprintf(stream, "%s\n", algos_table[i].name);
+}		/* -----  end of function digest_list  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  worker
+ *  Description:  Thread start routine.  Adds every buffer posted
+ *                to the job to its algorithm's ctx, until a buffer
+ *                of length 0 is posted.
+ * ==============================================================
+ */
+static void *
+worker(void *arg)
+{
+    struct digest_worker_s *w   = arg;
+    struct digest_job_s    *job = w->job;
+    const uint8 *buf;
+    ssize_t len;
+    uint64  seen = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        while (job->gen == seen)
+            pthread_cond_wait(&job->cond, &job->lock);
+        seen = job->gen;
+        buf  = job->buf;
+        len  = job->len;
+        pthread_mutex_unlock(&job->lock);
+
+        if (len == 0)
+            break;
+
+        w->algo->update(w->ctx, buf, len);
+
+        pthread_mutex_lock(&job->lock);
+        if (--job->pending == 0)
+            pthread_cond_broadcast(&job->cond);
+        pthread_mutex_unlock(&job->lock);
+    }
+
+    return NULL;
+}		/* -----  end of static function worker  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  post
+ *  Description:  Hands buf to the nworkers threads of job;
+ *                wait_workers( ) then waits for them to finish
+ *                with it.  A len of 0 makes the threads exit.
+ * ==============================================================
+ */
+static void
+post(struct digest_job_s *job, int nworkers, const uint8 *buf, ssize_t len)
+{
+    pthread_mutex_lock(&job->lock);
+
+    job->buf     = buf;
+    job->len     = len;
+    job->pending = nworkers;
+    job->gen++;
+    pthread_cond_broadcast(&job->cond);
+
+    pthread_mutex_unlock(&job->lock);
+}		/* -----  end of static function post  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  wait_workers
+ *  Description:  Waits until every thread is done with the last
+ *                buffer posted to job.
+ * ==============================================================
+ */
+static void
+wait_workers(struct digest_job_s *job)
+{
+    pthread_mutex_lock(&job->lock);
+    while (job->pending > 0)
+        pthread_cond_wait(&job->cond, &job->lock);
+    pthread_mutex_unlock(&job->lock);
+}		/* -----  end of static function wait_workers  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  digest_file
+ *  Description:  API function to compute the nalgos digests given
+ *                by algos over the file given by filename (or
+ *                stdin if filename is NULL), reading it only once.
+ *                digests[i] receives the digest of algos[i].
+ *
+ *                The input is read by a pipeline_s into shared
+ *                buffers (or, if it can't be started, DIGEST_SLICE
+ *                bytes at a time by the calling thread).  With nthreads > 1 (nthreads <= 0 means
+ *                one per online processor) every algorithm but the
+ *                first gets a thread of its own and the calling
+ *                thread runs the first one, so a buffer costs as
+ *                long as the slowest algorithm rather than all of
+ *                them together.  Otherwise the algorithms take
+ *                turns on each DIGEST_SLICE of a buffer.
+ *
+ *                The contexts and the pipeline's buffers come from
+ *                arena, which is reset first, so a caller hashing
+ *                file after file with the same arena allocates
+ *                nothing after the first one.  The contexts are
+ *                each on their own cache lines, as they are
+ *                updated by different threads.  A NULL arena uses
+ *                a temporary one.
+ *
+ *                Returns 0 on success or -1 on failure, after
+ *                printing the reason to stderr.
+ * ==============================================================
+ */
+int
+digest_file(char *filename, const struct digest_algo_s **algos,
+            int nalgos, int nthreads, struct arena_s *arena,
+            uint8 digests[][DIGEST_MAX_SIZE])
+{
+    struct arena_s         local;
+    struct digest_worker_s workers[DIGEST_MAX_ALGOS];
+    struct digest_job_s    job;
+    struct pipeline_s      pl;
+
+    void        *ctx[DIGEST_MAX_ALGOS];
+    uint8        slice[DIGEST_SLICE];
+    const uint8 *buf = slice;
+    ssize_t      n;
+    size_t       off, len;
+    int          fd = STDIN_FILENO;
+    int          started = 0;
+    int          sync;
+    int          i;
+
+    if (nalgos > DIGEST_MAX_ALGOS) {
+        fprintf(stderr, "at most %d algorithms at once\n", DIGEST_MAX_ALGOS);
+        return -1;
+    }
+
+    if (nthreads <= 0)
+        nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (filename && (fd = open(filename, O_RDONLY)) < 0) {
+        fprintf(stderr, "couldn't open file '%s'\n", filename);
+        return -1;
+    }
+
+    if (arena == NULL) {
+        arena = &local;
+        if (arena_init(arena) != 0) {
+            fprintf(stderr, "out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    arena_reset(arena);
+
+    for (i = 0; i < nalgos; i++) {
+        ctx[i] = arena_ctx(arena, algos[i]->ctx_size);
+        if (ctx[i] == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        algos[i]->init(ctx[i]);
+    }
+
+    /* without a mapped buffer the pipeline allocates its own */
+    sync = pipeline_start(&pl, fd, arena_io(arena, PIPELINE_SIZE)) != 0;
+
+    /* algorithms 1..nalgos-1 on their own threads */
+    if (nthreads > 1 && nalgos > 1) {
+        job.gen     = 0;
+        job.pending = 0;
+        pthread_mutex_init(&job.lock, NULL);
+        pthread_cond_init(&job.cond, NULL);
+
+        for (started = 0; started < nalgos - 1; started++) {
+            workers[started].job  = &job;
+            workers[started].algo = algos[started + 1];
+            workers[started].ctx  = ctx[started + 1];
+
+            if (pthread_create(&workers[started].thread, NULL, worker,
+                               &workers[started]) != 0)
+                break;
+        }
+
+        /* all or nothing: the threads haven't seen any data yet */
+        if (started < nalgos - 1) {
+            post(&job, started, NULL, 0);
+            for (i = 0; i < started; i++)
+                pthread_join(workers[i].thread, NULL);
+            started = 0;
+        }
+    }
+
+    while ((n = sync ? stats_read(fd, slice, sizeof(slice))
+                     : pipeline_next(&pl, &buf)) > 0) {
+        if (started > 0) {
+            post(&job, started, buf, n);
+            algos[0]->update(ctx[0], buf, n);
+            wait_workers(&job);
+            continue;
+        }
+
+        for (off = 0; off < (size_t) n; off += len) {
+            len = n - off;
+            if (len > DIGEST_SLICE)
+                len = DIGEST_SLICE;
+
+            for (i = 0; i < nalgos; i++)
+                algos[i]->update(ctx[i], buf + off, len);
+        }
+    }
+
+    if (started > 0) {
+        post(&job, started, NULL, 0);
+        for (i = 0; i < started; i++)
+            pthread_join(workers[i].thread, NULL);
+    }
+
+    if (nthreads > 1 && nalgos > 1) {
+        pthread_cond_destroy(&job.cond);
+        pthread_mutex_destroy(&job.lock);
+    }
+
+    if (!sync)
+        pipeline_finish(&pl);
+
+    if (filename)
+        close(fd);
+
+    if (n < 0)
+        fprintf(stderr, "error reading '%s'\n", filename ? filename : "-");
+
+    if (n == 0) {
+        for (i = 0; i < nalgos; i++)
+            algos[i]->final(ctx[i], digests[i]);
+    }
+
+    if (arena == &local)
+        arena_free(arena);
+
+    return n < 0 ? -1 : 0;
+}		/* -----  end of function digest_file  ----- */
@@ -0,0 +1,280 @@
+/*
+ * ==============================================================
+ *       Filename:  engine.c
+ *
+ *    Description:  Compression engines.  Each engine is an
+ *                  implementation of the SHA-1 compression
+ *                  function (what compute_hash( ) does for one
+ *                  msg block); the fastest one the CPU supports
+ *                  is picked at run time.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#include <string.h>
+#include <pthread.h>
+#include "engine.h"
+#include "stats.h"
+
+#if defined(SHA_IFUNC) && defined(__aarch64__)
+#include <sys/auxv.h>
+
+#ifndef HWCAP_SHA1
+#define HWCAP_SHA1   (1 << 5)
+#endif
+#endif
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  generic_available
+ *  Description:  The portable engine runs everywhere.
+ * ==============================================================
+ */
+static int
+generic_available(void)
+{
+    return 1;
+}		/* -----  end of static function generic_available  ----- */
+
+
+/******************** GLOBAL VARIABLES *************************/
+
+/* every engine built for this target, fastest first */
+static const struct engine_s engines[] = {
+#if defined(__aarch64__) && !defined(DEBUG)
+    { "armv8-ce", ENGINE_ARMV8_CE, sha_arm_ce_available,
+      sha_compress_arm_ce, NULL },
+    { "neon",     ENGINE_NEON,     sha_neon_available,
+      sha_compress_generic, sha_compress_neon_x4 },
+#endif
+    { "generic",  ENGINE_GENERIC,  generic_available,
+      sha_compress_generic, NULL },
+
+    /* slower than generic, so only used when asked for */
+    { "sha1dc",   ENGINE_SHA1DC,   generic_available,
+      sha_compress_dc, NULL }
+};
+
+#define NUM_ENGINES  (sizeof(engines) / sizeof(engines[0]))
+
+/* the engine in use; picked once, on first use */
+static const struct engine_s *current = NULL;
+static pthread_once_t         current_once = PTHREAD_ONCE_INIT;
+
+/**************************************************************/
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  pick_engine
+ *  Description:  Selects the first (fastest) engine in the table
+ *                that this CPU can run, unless engine_select( )
+ *                already chose one.
+ * ==============================================================
+ */
+static void
+pick_engine(void)
+{
+    size_t i;
+
+    if (current != NULL)
+        return;
+
+    for (i = 0; i < NUM_ENGINES; i++) {
+        if (engines[i].available()) {
+            current = &engines[i];
+            return;
+        }
+    }
+}		/* -----  end of static function pick_engine  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  engine_get
+ *  Description:  Returns the compression engine in use.  The
+ *                first call picks it; later calls are a single
+ *                pthread_once check, so callers don't need to
+ *                cache the result.
+ * ==============================================================
+ */
+const struct engine_s *
+engine_get(void)
+{
+    pthread_once(&current_once, pick_engine);
+
+    return current;
+}		/* -----  end of function engine_get  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  engine_select
+ *  Description:  Forces the engine called name, e.g. to compare
+ *                engines against each other.  Must be called
+ *                before any hashing starts.  Returns 0 on
+ *                success or -1 if there is no such engine or
+ *                this CPU can't run it.
+ * ==============================================================
+ */
+int
+engine_select(const char *name)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_ENGINES; i++) {
+        if (strcmp(engines[i].name, name) == 0 && engines[i].available()) {
+            current = &engines[i];
+            return 0;
+        }
+    }
+
+    return -1;
+}		/* -----  end of function engine_select  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  engine_at
+ *  Description:  Returns the i-th engine built for this target,
+ *                fastest first, whether or not this CPU can run
+ *                it (see its available( )), or NULL past the last
+ *                one.  For tools that go through every engine.
+ * ==============================================================
+ */
+const struct engine_s *
+engine_at(size_t i)
+{
+    return i < NUM_ENGINES ? &engines[i] : NULL;
+}		/* -----  end of function engine_at  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  engine_list
+ *  Description:  Prints the name of every engine this CPU can
+ *                run, one per line, fastest first.
+ * ==============================================================
+ */
+void
+engine_list(FILE *stream)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_ENGINES; i++) {
+        if (engines[i].available())
+            fprintf(stream, "%s\n", engines[i].name);
+    }
+}		/* -----  end of function engine_list  ----- */
+
+
+
+#ifdef SHA_IFUNC
+typedef void (*compress_fn)(struct sha_hash_s *hash, const uint8 *blocks,
+                            size_t nblocks);
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  resolve_compress
+ *  Description:  IFUNC resolver for sha_compress_auto( ), run by
+ *                the dynamic linker while libsha1 is loaded.  Its
+ *                relocations aren't all done yet, so it must not
+ *                read engines[ ] or call into libc: on aarch64
+ *                glibc passes it AT_HWCAP instead.  Makes the same
+ *                choice as pick_engine( ).
+ * ==============================================================
+ */
+static compress_fn
+resolve_compress(unsigned long hwcap)
+{
+#if defined(__aarch64__) && !defined(DEBUG)
+    if (hwcap & HWCAP_SHA1)
+        return sha_compress_arm_ce;
+#endif
+
+    (void) hwcap;
+
+    return sha_compress_generic;
+}		/* -----  end of static function resolve_compress  ----- */
+
+void sha_compress_auto(struct sha_hash_s *hash, const uint8 *blocks,
+                       size_t nblocks)
+    __attribute__((ifunc("resolve_compress")));
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  auto_name_ce, auto_name_generic
+ *  Description:  The implementations of sha_compress_auto_name( ),
+ *                one per kernel resolve_compress( ) can bind.
+ * ==============================================================
+ */
+#if defined(__aarch64__) && !defined(DEBUG)
+static const char *
+auto_name_ce(void)
+{
+    return "armv8-ce";
+}		/* -----  end of static function auto_name_ce  ----- */
+#endif
+
+static const char *
+auto_name_generic(void)
+{
+    return "generic";
+}		/* -----  end of static function auto_name_generic  ----- */
+
+
+
+typedef const char *(*name_fn)(void);
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  resolve_name
+ *  Description:  IFUNC resolver for sha_compress_auto_name( ): asks
+ *                resolve_compress( ) which kernel it binds for this
+ *                hwcap, so the name can't disagree with it.
+ * ==============================================================
+ */
+static name_fn
+resolve_name(unsigned long hwcap)
+{
+#if defined(__aarch64__) && !defined(DEBUG)
+    if (resolve_compress(hwcap) == sha_compress_arm_ce)
+        return auto_name_ce;
+#endif
+
+    (void) hwcap;
+
+    return auto_name_generic;
+}		/* -----  end of static function resolve_name  ----- */
+
+const char *sha_compress_auto_name(void)
+    __attribute__((ifunc("resolve_name")));
+#endif
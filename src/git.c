@@ -0,0 +1,159 @@
+/*
+ * ==============================================================
+ *       Filename:  git.c
+ *
+ *    Description:  Git object IDs.  Git names an object by the
+ *                  SHA-1 msg digest of "<type> <size>\0" followed
+ *                  by the object's content; for a file that is
+ *                  the blob "blob <size>\0<file contents>".
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "git.h"
+
+
+/* room for the longest type name, a space, 20 digits and '\0' */
+#define GIT_HEADER_SIZE  64
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  git_object_init
+ *  Description:  API function to prepare hash for a git object
+ *                of the given type ("blob", "tree", ...) whose
+ *                content is length bytes long.  The header
+ *                "<type> <length>\0" is injected into hash, so the
+ *                caller only has to stream the content through
+ *                sha_hash_update( ) and finish with
+ *                sha_hash_final( ).
+ *
+ *                Returns 0 on success or -1 if type is too long.
+ * ==============================================================
+ */
+int
+git_object_init(struct sha_hash_s *hash, const char *type, uint64 length)
+{
+    char header[GIT_HEADER_SIZE];
+    int  n;
+
+    n = snprintf(header, sizeof(header), "%s %llu", type, length);
+    if (n < 0 || n >= (int) sizeof(header))
+        return -1;
+
+    sha_hash_init(hash);
+
+    /* the terminating '\0' is part of the header */
+    sha_hash_update(hash, (const uint8 *) header, n + 1);
+
+    return 0;
+}		/* -----  end of function git_object_init  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  git_hash_file
+ *  Description:  API function to compute the git object ID of the
+ *                file given by filename (or stdin if filename is
+ *                NULL) as an object of the given type, usually
+ *                GIT_TYPE_BLOB.  The size in the header comes from
+ *                fstat(2), so the file is streamed straight
+ *                through sha_hash_update_fd( ) without being
+ *                buffered; it must therefore be a regular file.
+ *
+ *                Returns 0 and fills in digest (DIGEST_SIZE
+ *                bytes) on success.  Returns -1 after printing
+ *                the reason to stderr if the file can't be read
+ *                or its size changed while it was being hashed.
+ * ==============================================================
+ */
+int
+git_hash_file(char *filename, const char *type, uint8 *digest)
+{
+    struct sha_hash_s hash;
+    struct stat st;
+    const char *name = filename ? filename : "-";
+    long long   n;
+    int fd;
+    int ret = -1;
+
+    if (filename) {
+
+        fd = open(filename, O_RDONLY);
+
+        if (fd < 0) {
+            fprintf(stderr, "couldn't open file '%s'\n", name);
+            return -1;
+        }
+
+    } else {
+
+        fd = STDIN_FILENO;
+    }
+
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "'%s' is not a regular file; its size isn't known\n",
+                name);
+        goto out;
+    }
+
+    if (git_object_init(&hash, type, st.st_size) != 0) {
+        fprintf(stderr, "invalid object type '%s'\n", type);
+        goto out;
+    }
+
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    n = sha_hash_update_fd(&hash, fd);
+
+    if (n < 0) {
+        fprintf(stderr, "error reading '%s'\n", name);
+        goto out;
+    }
+
+    /* the header already went into the digest, so a file that grew
+     * or shrank under us would produce a bogus id */
+    if (n != (long long) st.st_size) {
+        fprintf(stderr, "'%s' changed size while being hashed\n", name);
+        goto out;
+    }
+
+    sha_hash_final(&hash, digest);
+    ret = 0;
+
+out:
+    if (filename)
+        close(fd);
+
+    return ret;
+}		/* -----  end of function git_hash_file  ----- */
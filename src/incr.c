@@ -0,0 +1,494 @@
+/*
+ * ==============================================================
+ *       Filename:  incr.c
+ *
+ *    Description:  Incremental hashing of append-only files.  The
+ *                  intermediate SHA-1 state after the last byte
+ *                  hashed is kept in a state file next to the
+ *                  file, so the next run only hashes what has been
+ *                  appended since.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  SHA-1 is a Merkle-Damgard hash: after n bytes, everything that
+ *  matters about them is H[0..4], the length and the bytes of the
+ *  unfinished msg block.  Saving those (before padding) and loading
+ *  them later is the same as never having stopped, so the digest of
+ *  the whole file comes out right.
+ *
+ *  The saved state is only trusted for the same file (device and
+ *  inode), if it is no shorter than it was, and if the first and the
+ *  last INCR_TAIL_SIZE bytes of what was hashed still hash to what
+ *  they did.  A file that hasn't grown must also have the same
+ *  modification and change times, so a rewrite in place of the same
+ *  length is hashed again even where both checks miss it.  A file
+ *  that has grown has new times anyway, so a rewrite of its middle
+ *  along with the append goes unnoticed; only hashing it all again,
+ *  which is what not using --incremental is for, can catch that.
+ *
+ *  The checks are hashed by sha_compress_generic( ) on a context of
+ *  their own, whatever engine is selected: sha1dc would flag a check
+ *  over an attack block as a collision of the file, and none of it
+ *  is counted by --stats, which only reports the file itself.
+ *
+ *  A state saved by the sha1dc engine (--detect-collisions) is only
+ *  resumed by it, and the other way round: sha1dc's chaining values
+ *  differ after an attack block, and the blocks hashed by the other
+ *  engine were never checked.  Whether an attack block has been
+ *  seen is saved too, so it is still reported on later runs.
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "incr.h"
+#include "engine.h"
+#include "stats.h"
+
+
+/* what is kept in the state file */
+struct incr_state_s {
+
+    uint64  dev;
+    uint64  ino;
+    uint64  size;                 /* bytes hashed into hash */
+    int     dc;                   /* hashed by the sha1dc engine */
+
+    struct sha_hash_s hash;       /* not yet padded */
+
+    uint32  head_len;             /* bytes from 0 in the head check */
+    uint8   head[DIGEST_SIZE];    /* their digest */
+    uint32  tail_len;             /* bytes before size in the check */
+    uint8   tail[DIGEST_SIZE];    /* their digest */
+
+    long long mtime, ctime;       /* seconds */
+    long    mtime_ns, ctime_ns;   /* and nanoseconds */
+
+};
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  to_hex, from_hex
+ *  Description:  Convert len bytes to and from 2 * len lowercase
+ *                hex digits.  from_hex( ) returns 0 on success or
+ *                -1 if hex isn't exactly that.
+ * ==============================================================
+ */
+static void
+to_hex(const uint8 *buf, size_t len, char *hex)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+        sprintf(hex + 2 * i, "%02x", buf[i]);
+
+    hex[2 * len] = '\0';
+}		/* -----  end of static function to_hex  ----- */
+
+static int
+from_hex(const char *hex, uint8 *buf, size_t len)
+{
+    unsigned int byte;
+    size_t i;
+
+    if (strlen(hex) != 2 * len)
+        return -1;
+
+    for (i = 0; i < len; i++) {
+        if (sscanf(hex + 2 * i, "%2x", &byte) != 1)
+            return -1;
+        buf[i] = byte;
+    }
+
+    return 0;
+}		/* -----  end of static function from_hex  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  region_check
+ *  Description:  Computes the SHA-1 digest of the len (at most
+ *                INCR_TAIL_SIZE) bytes of fd at offset off.  Reads
+ *                with pread(2), so the file offset is left alone,
+ *                and pads and compresses them itself with
+ *                sha_compress_generic( ), so neither the selected
+ *                engine nor the stats see them.  Returns 0 on
+ *                success or -1 if they can't all be read.
+ * ==============================================================
+ */
+static int
+region_check(int fd, uint64 off, size_t len, uint8 *digest)
+{
+    struct sha_hash_s hash;
+    uint8   buf[INCR_TAIL_SIZE + 2 * BLK_SIZE];
+    uint64  bits = (uint64) len << 3;
+    size_t  nblocks = (len + 8) / BLK_SIZE + 1;
+    size_t  got = 0;
+    ssize_t n;
+    int     i;
+
+    while (got < len) {
+        n = pread(fd, buf + got, len - got, off + got);
+        if (n <= 0)
+            return -1;
+        got += n;
+    }
+
+    buf[len] = 0x80;
+    memset(buf + len + 1, 0, nblocks * BLK_SIZE - len - 1);
+
+    for (i = 0; i < 8; i++)
+        buf[nblocks * BLK_SIZE - 1 - i] = bits >> (8 * i);
+
+    sha_hash_init(&hash);
+    sha_compress_generic(&hash, buf, nblocks);
+
+    for (i = 0; i < DIGEST_SIZE; i++)
+        digest[i] = hash.h_sub[i / 4] >> (24 - 8 * (i % 4));
+
+    return 0;
+}		/* -----  end of static function region_check  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  end_checks
+ *  Description:  Fills in the head and tail checks of s for the
+ *                first s->size bytes of fd.  Returns 0 on success
+ *                or -1 if they can't be read.
+ * ==============================================================
+ */
+static int
+end_checks(int fd, struct incr_state_s *s)
+{
+    size_t len = s->size < INCR_TAIL_SIZE ? s->size : INCR_TAIL_SIZE;
+
+    s->head_len = len;
+    s->tail_len = len;
+
+    if (region_check(fd, 0, len, s->head) != 0
+            || region_check(fd, s->size - len, len, s->tail) != 0)
+        return -1;
+
+    return 0;
+}		/* -----  end of static function end_checks  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  load_state
+ *  Description:  Reads the state file at path into s.  Returns 0
+ *                on success or -1 if there is none or it can't be
+ *                parsed.
+ * ==============================================================
+ */
+static int
+load_state(const char *path, struct incr_state_s *s)
+{
+    unsigned long long dev, ino, size;
+    unsigned int h[5], hi, lo, idx, head_len, tail_len, dc, collision;
+    char  block[2 * BLK_SIZE + 1];
+    char  head[2 * DIGEST_SIZE + 1], tail[2 * DIGEST_SIZE + 1];
+    long long mtime, ctime;
+    long  mtime_ns, ctime_ns;
+    FILE *in;
+    int   n, i;
+
+    if ((in = fopen(path, "r")) == NULL)
+        return -1;
+
+    n = fscanf(in, "sha1state 3 file %llu %llu %llu"
+                   " time %lld %ld %lld %ld"
+                   " h %8x %8x %8x %8x %8x length %8x %8x"
+                   " block %u %128s head %u %40s tail %u %40s dc %u %u",
+               &dev, &ino, &size, &mtime, &mtime_ns, &ctime, &ctime_ns,
+               &h[0], &h[1], &h[2], &h[3], &h[4], &hi, &lo, &idx, block,
+               &head_len, head, &tail_len, tail, &dc, &collision);
+
+    fclose(in);
+
+    if (n != 22 || idx >= BLK_SIZE || head_len > INCR_TAIL_SIZE
+            || tail_len > INCR_TAIL_SIZE || dc > 1 || collision > dc)
+        return -1;
+
+    if (idx == 0 ? strcmp(block, "-") != 0
+                 : from_hex(block, s->hash.msg_block, idx) != 0)
+        return -1;
+
+    if (from_hex(head, s->head, DIGEST_SIZE) != 0
+            || from_hex(tail, s->tail, DIGEST_SIZE) != 0)
+        return -1;
+
+    s->dev  = dev;
+    s->ino  = ino;
+    s->size = size;
+    s->dc   = dc;
+
+    s->mtime    = mtime;
+    s->mtime_ns = mtime_ns;
+    s->ctime    = ctime;
+    s->ctime_ns = ctime_ns;
+
+    for (i = 0; i < 5; i++)
+        s->hash.h_sub[i] = h[i];
+
+    s->hash.hi_length = hi;
+    s->hash.lo_length = lo;
+    s->hash.msg_idx   = idx;
+    s->hash.collision = collision;
+    s->head_len       = head_len;
+    s->tail_len       = tail_len;
+
+    /* the length must agree with the bytes said to be hashed */
+    if ((((uint64) hi << 32) | lo) != size << 3 || size % BLK_SIZE != idx)
+        return -1;
+
+    return 0;
+}		/* -----  end of static function load_state  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  save_state
+ *  Description:  Writes s to the state file at path, by way of a
+ *                temporary file renamed over it, so a crash never
+ *                leaves a half-written state behind.  The temporary
+ *                file gets a unique name from mkstemp(3), in the
+ *                same directory so the rename stays atomic, so
+ *                concurrent runs can't write into each other's.
+ *                Returns 0 on success or -1 on failure.
+ * ==============================================================
+ */
+static int
+save_state(const char *path, const struct incr_state_s *s)
+{
+    char  block[2 * BLK_SIZE + 1];
+    char  head[2 * DIGEST_SIZE + 1], tail[2 * DIGEST_SIZE + 1];
+    char *tmp;
+    FILE *out;
+    int   fd, ret = -1;
+
+    if ((tmp = malloc(strlen(path) + 8)) == NULL)
+        return -1;
+
+    sprintf(tmp, "%s.XXXXXX", path);
+
+    if (s->hash.msg_idx == 0)
+        strcpy(block, "-");
+    else
+        to_hex(s->hash.msg_block, s->hash.msg_idx, block);
+
+    to_hex(s->head, DIGEST_SIZE, head);
+    to_hex(s->tail, DIGEST_SIZE, tail);
+
+    if ((fd = mkstemp(tmp)) < 0) {
+        free(tmp);
+        return -1;
+    }
+
+    if ((out = fdopen(fd, "w")) == NULL) {
+        close(fd);
+        unlink(tmp);
+    } else {
+        fprintf(out, "sha1state 3\n"
+                     "file %llu %llu %llu\n"
+                     "time %lld %ld %lld %ld\n"
+                     "h %08x %08x %08x %08x %08x\n"
+                     "length %08x %08x\n"
+                     "block %u %s\n"
+                     "head %u %s\n"
+                     "tail %u %s\n"
+                     "dc %u %u\n",
+                (unsigned long long) s->dev, (unsigned long long) s->ino,
+                (unsigned long long) s->size,
+                s->mtime, s->mtime_ns, s->ctime, s->ctime_ns,
+                (unsigned int) s->hash.h_sub[0], (unsigned int) s->hash.h_sub[1],
+                (unsigned int) s->hash.h_sub[2], (unsigned int) s->hash.h_sub[3],
+                (unsigned int) s->hash.h_sub[4],
+                (unsigned int) s->hash.hi_length, (unsigned int) s->hash.lo_length,
+                (unsigned int) s->hash.msg_idx, block,
+                (unsigned int) s->head_len, head,
+                (unsigned int) s->tail_len, tail,
+                (unsigned int) s->dc, (unsigned int) s->hash.collision);
+
+        if (fclose(out) == 0 && rename(tmp, path) == 0)
+            ret = 0;
+        else
+            unlink(tmp);
+    }
+
+    free(tmp);
+
+    return ret;
+}		/* -----  end of static function save_state  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  resumable
+ *  Description:  Returns 1 if the state old, saved by an earlier
+ *                call, still applies to the file open as fd, of
+ *                size bytes, that cur describes (see the top of
+ *                this file), and seeks fd to where old stopped.
+ *                Returns 0 if the file must be hashed again.
+ * ==============================================================
+ */
+static int
+resumable(int fd, const struct incr_state_s *old,
+          const struct incr_state_s *cur, uint64 size)
+{
+    struct incr_state_s check;
+
+    if (old->dev != cur->dev || old->ino != cur->ino || old->dc != cur->dc
+            || old->size > size)
+        return 0;
+
+    if (old->size == size
+            && (old->mtime != cur->mtime || old->mtime_ns != cur->mtime_ns
+                || old->ctime != cur->ctime || old->ctime_ns != cur->ctime_ns))
+        return 0;
+
+    check.size = old->size;
+
+    if (end_checks(fd, &check) != 0
+            || check.head_len != old->head_len
+            || check.tail_len != old->tail_len
+            || memcmp(check.head, old->head, DIGEST_SIZE) != 0
+            || memcmp(check.tail, old->tail, DIGEST_SIZE) != 0)
+        return 0;
+
+    return lseek(fd, old->size, SEEK_SET) == (off_t) old->size;
+}		/* -----  end of static function resumable  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  incr_hash_file
+ *  Description:  API function to compute the msg digest of the
+ *                regular file given by filename into digest,
+ *                picking up from the state saved in
+ *                filename INCR_SUFFIX by the previous call if it
+ *                still applies (see the top of this file), and
+ *                saving the state for the next call.  *collision
+ *                is set if the sha1dc engine has found an attack
+ *                block in the file, in this call or an earlier one.
+ *
+ *                Returns INCR_APPENDED if only the bytes appended
+ *                since the last call were hashed, INCR_FULL if the
+ *                whole file was, or INCR_FAILED after printing the
+ *                reason to stderr.  Failing to save the state is
+ *                only warned about, since the digest is still
+ *                right.
+ * ==============================================================
+ */
+int
+incr_hash_file(const char *filename, uint8 *digest, int *collision)
+{
+    struct incr_state_s old, cur;
+    struct stat st;
+    char  *state_path;
+    long long n;
+    int    fd;
+    int    ret = INCR_FAILED;
+
+    if ((fd = open(filename, O_RDONLY)) < 0) {
+        fprintf(stderr, "couldn't open file '%s'\n", filename);
+        return INCR_FAILED;
+    }
+
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        fprintf(stderr, "'%s' is not a regular file\n", filename);
+        close(fd);
+        return INCR_FAILED;
+    }
+
+    state_path = malloc(strlen(filename) + sizeof(INCR_SUFFIX));
+    if (state_path == NULL) {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    sprintf(state_path, "%s%s", filename, INCR_SUFFIX);
+
+    cur.dev  = st.st_dev;
+    cur.ino  = st.st_ino;
+    cur.size = 0;
+    cur.dc   = engine_get()->id == ENGINE_SHA1DC;
+
+    /* taken before reading: a write racing the read leaves times the
+     * next call won't match, so it hashes the file again */
+    cur.mtime    = st.st_mtim.tv_sec;
+    cur.mtime_ns = st.st_mtim.tv_nsec;
+    cur.ctime    = st.st_ctim.tv_sec;
+    cur.ctime_ns = st.st_ctim.tv_nsec;
+
+    if (load_state(state_path, &old) == 0 && resumable(fd, &old, &cur,
+                                                       st.st_size)) {
+
+        cur.hash = old.hash;
+        cur.size = old.size;
+        ret = INCR_APPENDED;
+
+    } else {
+
+        sha_hash_init(&cur.hash);
+        ret = INCR_FULL;
+    }
+
+    n = sha_hash_update_fd(&cur.hash, fd);
+
+    if (n < 0) {
+        fprintf(stderr, "error reading '%s'\n", filename);
+        ret = INCR_FAILED;
+        goto out;
+    }
+
+    cur.size += n;
+
+    /* the state must be saved before the padding goes in */
+    if (end_checks(fd, &cur) != 0
+            || save_state(state_path, &cur) != 0)
+        fprintf(stderr, "couldn't save state '%s'\n", state_path);
+
+    *collision = cur.hash.collision;
+    sha_hash_final(&cur.hash, digest);
+
+out:
+    free(state_path);
+    close(fd);
+
+    return ret;
+}		/* -----  end of function incr_hash_file  ----- */
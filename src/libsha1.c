@@ -0,0 +1,193 @@
+/*
+ * ==============================================================
+ *       Filename:  libsha1.c
+ *
+ *    Description:  The exported API of libsha1 (see libsha1.h), a
+ *                  thin layer over the incremental interface in
+ *                  sha1.c that keeps struct sha_hash_s out of the
+ *                  ABI.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "libsha1.h"
+#include "sha1.h"
+#include "engine.h"
+
+
+struct sha1_ctx {
+
+    struct sha_hash_s hash;
+
+};
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha1_abi_version
+ *  Description:  Returns the SHA1_ABI_VERSION the library was
+ *                built with, so a caller can check that it got
+ *                the library it was compiled against.
+ * ==============================================================
+ */
+unsigned int
+sha1_abi_version(void)
+{
+    return SHA1_ABI_VERSION;
+}		/* -----  end of function sha1_abi_version  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha1_engine
+ *  Description:  Returns the name of the compression engine in
+ *                use, e.g. "generic" or "armv8-ce": in the library,
+ *                the one the IFUNC resolver bound, which isn't
+ *                always engine_get( )'s pick (on a CPU with NEON but
+ *                no SHA1 instructions that is "neon", whose plain
+ *                kernel is the generic one).
+ * ==============================================================
+ */
+const char *
+sha1_engine(void)
+{
+#ifdef SHA_IFUNC
+    return sha_compress_auto_name();
+#else
+    return engine_get()->name;
+#endif
+}		/* -----  end of function sha1_engine  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha1_new, sha1_free
+ *  Description:  Allocate a context, ready for sha1_update( ) (or
+ *                NULL if out of memory), and release it.
+ * ==============================================================
+ */
+sha1_ctx *
+sha1_new(void)
+{
+    sha1_ctx *ctx = malloc(sizeof(*ctx));
+
+    if (ctx)
+        sha_hash_init(&ctx->hash);
+
+    return ctx;
+}		/* -----  end of function sha1_new  ----- */
+
+void
+sha1_free(sha1_ctx *ctx)
+{
+    free(ctx);
+}		/* -----  end of function sha1_free  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha1_reset, sha1_update, sha1_final
+ *  Description:  Start a new msg, add len bytes of buf to it, and
+ *                write its SHA1_DIGEST_SIZE byte digest to digest.
+ *                After sha1_final( ), the context must be reset
+ *                before it is used again.
+ * ==============================================================
+ */
+void
+sha1_reset(sha1_ctx *ctx)
+{
+    sha_hash_init(&ctx->hash);
+}		/* -----  end of function sha1_reset  ----- */
+
+void
+sha1_update(sha1_ctx *ctx, const void *buf, size_t len)
+{
+    sha_hash_update(&ctx->hash, buf, len);
+}		/* -----  end of function sha1_update  ----- */
+
+void
+sha1_final(sha1_ctx *ctx, unsigned char *digest)
+{
+    sha_hash_final(&ctx->hash, digest);
+}		/* -----  end of function sha1_final  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha1_digest
+ *  Description:  Writes the digest of the len bytes of buf to
+ *                digest, in one call.
+ * ==============================================================
+ */
+void
+sha1_digest(const void *buf, size_t len, unsigned char *digest)
+{
+    struct sha_hash_s hash;
+
+    sha_hash_init(&hash);
+    sha_hash_update(&hash, buf, len);
+    sha_hash_final(&hash, digest);
+}		/* -----  end of function sha1_digest  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha1_file
+ *  Description:  Writes the digest of the file at path to digest.
+ *                Unlike the program's sha_hash_file( ), it never
+ *                prints or exits: it returns 0 on success or -1
+ *                with errno set.
+ * ==============================================================
+ */
+int
+sha1_file(const char *path, unsigned char *digest)
+{
+    struct sha_hash_s hash;
+    long long n;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) < 0)
+        return -1;
+
+    sha_hash_init(&hash);
+    n = sha_hash_update_fd(&hash, fd);
+    close(fd);
+
+    if (n < 0)
+        return -1;
+
+    sha_hash_final(&hash, digest);
+
+    return 0;
+}		/* -----  end of function sha1_file  ----- */
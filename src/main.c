@@ -33,9 +33,750 @@
  * ==============================================================
  */
 
+#define _XOPEN_SOURCE 700
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <getopt.h>
+#include <unistd.h>
 #include "sha1.h"
+#include "cdc.h"
+#include "piece.h"
+#include "git.h"
+#include "stats.h"
+#include "server.h"
+#include "engine.h"
+#include "tee.h"
+#include "digest.h"
+#include "batch.h"
+#include "arena.h"
+#include "incr.h"
+#include "pipeline.h"
+
+
+/* what to do with each input file */
+enum mode_e {
+    MODE_HASH,          /* sha1sum style msg digest (default) */
+    MODE_CHUNK,         /* content-defined chunks and their digests */
+    MODE_PIECES,        /* fixed size pieces and the whole-file digest */
+    MODE_GIT_BLOB,      /* git blob object id */
+    MODE_SERVER,        /* run as a hashing daemon */
+    MODE_CLIENT,        /* ask a running --server for the digest */
+    MODE_TEE,           /* copy the input through, hashing it */
+    MODE_ALGOS,         /* several digests from one read */
+    MODE_INCREMENTAL    /* only hash what was appended */
+};
+
+/* everything set from the command line */
+struct options_s {
+
+    enum mode_e mode;
+
+    uint64  min_size;             /* --chunk sizes */
+    uint64  avg_size;
+    uint64  max_size;
+
+    uint64  piece_size;           /* --pieces */
+    int     nthreads;
+    int     binary;
+
+    char   *files_from;           /* file naming the files to hash ("-"
+                                     for stdin), or NULL for argv */
+    int     files_delim;          /* what ends each name in it */
+
+    char   *server;               /* --server / --client socket */
+    int     client_fd;
+    uint32  client_id;            /* id of the last request sent */
+
+    char   *sidecar;              /* --tee digest file, or NULL for stderr */
+
+    const struct digest_algo_s *algos[DIGEST_MAX_ALGOS];     /* --algo */
+    int     nalgos;
+
+    struct batch_s batch;         /* opens and reads files by name */
+    struct arena_s arena;         /* --algo contexts and buffers */
+
+};
+
+/* long-only options */
+enum {
+    OPT_MIN_SIZE = 256,
+    OPT_AVG_SIZE,
+    OPT_MAX_SIZE,
+    OPT_PIECE_SIZE,
+    OPT_BINARY,
+    OPT_GIT_BLOB,
+    OPT_BATCH,
+    OPT_STATS,
+    OPT_SERVER,
+    OPT_CLIENT,
+    OPT_ENGINE,
+    OPT_LIST_ENGINES,
+    OPT_TEE,
+    OPT_SIDECAR,
+    OPT_ALGO,
+    OPT_DETECT,
+    OPT_FILES_FROM,
+    OPT_FILES0_FROM,
+    OPT_INCREMENTAL
+};
+
+static struct option long_options[] = {
+    { "chunk",         no_argument,       NULL, 'c'              },
+    { "min-size",      required_argument, NULL, OPT_MIN_SIZE     },
+    { "avg-size",      required_argument, NULL, OPT_AVG_SIZE     },
+    { "max-size",      required_argument, NULL, OPT_MAX_SIZE     },
+    { "pieces",        no_argument,       NULL, 'p'              },
+    { "piece-size",    required_argument, NULL, OPT_PIECE_SIZE   },
+    { "threads",       required_argument, NULL, 't'              },
+    { "binary",        no_argument,       NULL, OPT_BINARY       },
+    { "git-blob",      no_argument,       NULL, OPT_GIT_BLOB     },
+    { "batch",         no_argument,       NULL, OPT_BATCH        },
+    { "files-from",    required_argument, NULL, OPT_FILES_FROM   },
+    { "files0-from",   required_argument, NULL, OPT_FILES0_FROM  },
+    { "stats",         no_argument,       NULL, OPT_STATS        },
+    { "server",        required_argument, NULL, OPT_SERVER       },
+    { "client",        required_argument, NULL, OPT_CLIENT       },
+    { "engine",        required_argument, NULL, OPT_ENGINE       },
+    { "list-engines",  no_argument,       NULL, OPT_LIST_ENGINES },
+    { "tee",           no_argument,       NULL, OPT_TEE          },
+    { "sidecar",       required_argument, NULL, OPT_SIDECAR      },
+    { "algo",          required_argument, NULL, OPT_ALGO         },
+    { "detect-collisions", no_argument,   NULL, OPT_DETECT       },
+    { "incremental",   no_argument,       NULL, OPT_INCREMENTAL  },
+    { "help",          no_argument,       NULL, 'h'              },
+    { NULL,            0,                 NULL, 0                }
+};
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  usage
+ *  Description:  Prints a short summary of the command line
+ *                options to stream.
+ * ==============================================================
+ */
+static void
+usage(FILE *stream)
+{
+    fprintf(stream,
+            "usage: sha1 [options] [file ...]\n"
+            "\n"
+            "  -c, --chunk       split each file into content-defined chunks\n"
+            "                    and print 'offset length digest  file' for\n"
+            "                    every chunk\n"
+            "      --min-size N  minimum chunk size (default %d)\n"
+            "      --avg-size N  average chunk size (default %d)\n"
+            "      --max-size N  maximum chunk size (default %d)\n"
+            "  -p, --pieces      split each file into fixed size pieces and\n"
+            "                    print 'offset length digest  file' for every\n"
+            "                    piece, then the digest of the whole file\n"
+            "      --piece-size N\n"
+            "                    piece size, a power of two from 16K to 16M\n"
+            "                    (default 256K)\n"
+            "  -t, --threads N   threads hashing pieces (default: one per CPU)\n"
+            "      --binary      with --pieces, write the raw 20 byte whole-file\n"
+            "                    digest followed by the raw piece digests\n"
+            "      --git-blob    print the git blob object id of each file,\n"
+            "                    as 'git hash-object' would\n"
+            "      --batch       read the file names from stdin, one per line,\n"
+            "                    and keep going if one of them fails\n"
+            "      --files-from FILE\n"
+            "                    like --batch, reading the names from FILE\n"
+            "      --files0-from FILE\n"
+            "                    like --files-from, with the names ended by\n"
+            "                    NUL characters, as 'find -print0' writes\n"
+            "      --stats       when done, print I/O and compression counters\n"
+            "                    and per stage timings to stderr as JSON\n"
+            "      --server SOCK run as a daemon answering hash requests on\n"
+            "                    the Unix socket SOCK, with --threads workers\n"
+            "      --client SOCK have the daemon on SOCK hash the files\n"
+            "      --engine NAME use the compression engine NAME instead of\n"
+            "                    the fastest one this CPU supports\n"
+            "      --list-engines\n"
+            "                    print the engines this CPU supports and exit\n"
+            "      --tee [SRC [DST]]\n"
+            "                    copy SRC (default stdin) to DST (default\n"
+            "                    stdout), printing the digest of the data\n"
+            "                    to stderr\n"
+            "      --sidecar FILE\n"
+            "                    with --tee, write the digest to FILE instead\n"
+            "                    of stderr\n"
+            "      --algo LIST   compute each digest in the comma separated\n"
+            "                    LIST (sha1, sha256) from a single read of\n"
+            "                    the file, one algorithm per thread, and\n"
+            "                    print 'ALGO (file) = digest' lines\n"
+            "      --detect-collisions\n"
+            "                    use the sha1dc engine, which checks every\n"
+            "                    block for a SHA-1 collision attack; files\n"
+            "                    found to be part of one are reported and\n"
+            "                    make the exit status non-zero; hashing is\n"
+            "                    about 40%% slower at -O2\n"
+            "      --incremental keep the hash state of each file in\n"
+            "                    'file%s' and, next time, only hash what\n"
+            "                    was appended to it since, if the rest is\n"
+            "                    unchanged\n"
+            "  -h, --help        print this help and exit\n"
+            "\n"
+            "Sizes accept a K, M or G suffix.  With no file, or when file\n"
+            "is -, read standard input.\n",
+            CDC_MIN_SIZE, CDC_AVG_SIZE, CDC_MAX_SIZE, INCR_SUFFIX);
+}
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  parse_size
+ *  Description:  Converts a size given on the command line, with
+ *                an optional K, M or G (binary) suffix, into a
+ *                number of bytes.  Exits on a malformed size or
+ *                one that doesn't fit in 64 bits.
+ * ==============================================================
+ */
+static uint64
+parse_size(const char *arg)
+{
+    char  *end;
+    uint64 n;
+    int    shift = 0;
+
+    errno = 0;
+    n = strtoull(arg, &end, 10);
+
+    switch (*end) {
+        case 'k': case 'K': shift = 10; end++; break;
+        case 'm': case 'M': shift = 20; end++; break;
+        case 'g': case 'G': shift = 30; end++; break;
+        default:            break;
+    }
+
+    /* strtoull( ) takes a sign, and wraps a negative number around */
+    if (end == arg || *end != '\0' || strchr(arg, '-') != NULL) {
+        fprintf(stderr, "invalid size '%s'\n", arg);
+        exit(EXIT_FAILURE);
+    }
+
+    if (errno == ERANGE || n > ULLONG_MAX >> shift) {
+        fprintf(stderr, "size '%s' is too large\n", arg);
+        exit(EXIT_FAILURE);
+    }
+
+    return n << shift;
+    return n;
+}
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  parse_algos
+ *  Description:  Fills in opts->algos from the comma separated
+ *                list of algorithm names in arg.  Returns 0 on
+ *                success or -1 after printing what was wrong.
+ * ==============================================================
+ */
+static int
+parse_algos(struct options_s *opts, char *arg)
+{
+    const struct digest_algo_s *algo;
+    char *name;
+
+    opts->nalgos = 0;
+
+    for (name = strtok(arg, ","); name; name = strtok(NULL, ",")) {
+        algo = digest_find(name);
+
+        if (algo == NULL) {
+            fprintf(stderr, "unknown algorithm '%s'; known ones are:\n", name);
+            digest_list(stderr);
+            return -1;
+        }
+
+        if (opts->nalgos == DIGEST_MAX_ALGOS) {
+            fprintf(stderr, "at most %d algorithms at once\n",
+                    DIGEST_MAX_ALGOS);
+            return -1;
+        }
+
+        opts->algos[opts->nalgos++] = algo;
+    }
+
+    if (opts->nalgos == 0) {
+        fprintf(stderr, "no algorithm given\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  print_chunk
+ *  Description:  cdc_emit_fn callback for --chunk; arg is the
+ *                name of the file being chunked.
+ * ==============================================================
+ */
+static void
+print_chunk(uint64 offset, uint64 length, const uint8 *digest, void *arg)
+{
+    char   hex[HEX_SIZE];
+    uint64 start = STATS_CLOCK();
+
+    sha_hash_hex(digest, hex);
+    printf("%llu %llu %s  %s\n", offset, length, hex, (char *) arg);
+
+    STATS_ADD(stage_ns[STAGE_OUTPUT], STATS_CLOCK() - start);
+}
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  print_pieces
+ *  Description:  Hashes filename in fixed size pieces and prints
+ *                the piece list, either as text records or as
+ *                raw digests (whole file first) when binary is
+ *                set.  Returns 0 on success or -1 if the file
+ *                couldn't be hashed.
+ * ==============================================================
+ */
+static int
+print_pieces(char *path, char *filename, uint64 piece_size, int nthreads,
+             int binary)
+{
+    struct piece_list_s list;
+    char   hex[HEX_SIZE];
+    uint64 i, length, start;
+
+    if (piece_hash_file(path, piece_size, nthreads, &list) != 0)
+        return -1;
+
+    start = STATS_CLOCK();
+
+    if (binary) {
+        fwrite(list.whole, 1, DIGEST_SIZE, stdout);
+        fwrite(list.digests, DIGEST_SIZE, list.count, stdout);
+
+    } else {
+        for (i = 0; i < list.count; i++) {
+            length = list.length - i * piece_size;
+            if (length > piece_size)
+                length = piece_size;
+
+            sha_hash_hex(list.digests + i * DIGEST_SIZE, hex);
+            printf("%llu %llu %s  %s\n", i * piece_size, length, hex, filename);
+        }
+
+        sha_hash_hex(list.whole, hex);
+        printf("%s  %s\n", hex, filename);
+    }
+
+    STATS_ADD(stage_ns[STAGE_OUTPUT], STATS_CLOCK() - start);
+
+    piece_list_free(&list);
+
+    return 0;
+}
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  print_git_blob
+ *  Description:  Prints the git blob object id of filename, in
+ *                the same 'digest  file' form as the default
+ *                mode.  Returns 0 on success or -1 if the file
+ *                couldn't be hashed.
+ * ==============================================================
+ */
+static int
+print_git_blob(char *path, char *filename)
+{
+    uint8  digest[DIGEST_SIZE];
+    char   hex[HEX_SIZE];
+    uint64 start;
+
+    if (git_hash_file(path, GIT_TYPE_BLOB, digest) != 0)
+        return -1;
+
+    start = STATS_CLOCK();
+
+    sha_hash_hex(digest, hex);
+    printf("%s  %s\n", hex, filename);
+
+    STATS_ADD(stage_ns[STAGE_OUTPUT], STATS_CLOCK() - start);
+
+    return 0;
+}
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  print_client
+ *  Description:  Has the --server on the other end of
+ *                opts->client_fd hash filename and prints the
+ *                result.  Files are sent as absolute paths, since
+ *                the server has its own working directory; stdin
+ *                is read here and sent inline.  Returns 0 on
+ *                success or -1 on failure.
+ * ==============================================================
+ */
+static int
+print_client(struct options_s *opts, char *path, char *filename)
+{
+    uint8   digest[DIGEST_SIZE];
+    char    hex[HEX_SIZE];
+    char    err[256];
+    char   *abs_path;
+    uint8  *data = NULL;
+    size_t  len = 0, size = 0;
+    int     ret;
+
+    if (path) {
+        abs_path = realpath(path, NULL);
+        if (abs_path == NULL) {
+            fprintf(stderr, "couldn't open file '%s'\n", path);
+            return -1;
+        }
+
+        ret = server_request(opts->client_fd, ++opts->client_id, REQ_PATH,
+                             abs_path, strlen(abs_path), digest,
+                             err, sizeof(err));
+        free(abs_path);
+
+    } else {
+        for (;;) {
+            if (len == size) {
+                size = size ? size * 2 : 64 * 1024;
+                data = realloc(data, size);
+                if (data == NULL) {
+                    fprintf(stderr, "out of memory\n");
+                    exit(EXIT_FAILURE);
+                }
+            }
+
+            ret = fread(data + len, 1, size - len, stdin);
+            if (ret <= 0)
+                break;
+            len += ret;
+        }
+
+        ret = server_request(opts->client_fd, ++opts->client_id, REQ_BUF,
+                             data, len, digest, err, sizeof(err));
+        free(data);
+    }
+
+    if (ret != 0) {
+        fprintf(stderr, "%s\n", err);
+        return -1;
+    }
+
+    sha_hash_hex(digest, hex);
+    printf("%s  %s\n", hex, filename);
+
+    return 0;
+}
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  print_digests
+ *  Description:  Computes the --algo digests of filename in one
+ *                pass and prints them in the BSD tagged form
+ *                'ALGO (file) = digest', one line per algorithm,
+ *                which says which digest is which.  Returns 0 on
+ *                success or -1 if the file couldn't be hashed.
+ * ==============================================================
+ */
+static int
+print_digests(struct options_s *opts, char *path, char *filename)
+{
+    uint8  digests[DIGEST_MAX_ALGOS][DIGEST_MAX_SIZE];
+    uint64 start;
+    size_t j;
+    int    i;
+
+    if (digest_file(path, opts->algos, opts->nalgos, opts->nthreads,
+                    &opts->arena, digests) != 0)
+        return -1;
+
+    start = STATS_CLOCK();
+
+    for (i = 0; i < opts->nalgos; i++) {
+        printf("%s (%s) = ", opts->algos[i]->tag, filename);
+        for (j = 0; j < opts->algos[i]->digest_size; j++)
+            printf("%02x", digests[i][j]);
+        printf("\n");
+    }
+
+    STATS_ADD(stage_ns[STAGE_OUTPUT], STATS_CLOCK() - start);
+
+    return 0;
+}
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  print_incremental
+ *  Description:  Prints 'digest  file' for the file at path,
+ *                hashing only what was appended to it since the
+ *                last run where its saved state allows.  stdin
+ *                has no place to keep a state.  Returns 0 on
+ *                success or -1 on failure, or if the sha1dc engine
+ *                found a collision attack in the file.
+ * ==============================================================
+ */
+static int
+print_incremental(char *path, char *filename)
+{
+    uint8  digest[DIGEST_SIZE];
+    char   hex[HEX_SIZE];
+    uint64 seen = sha_dc_detected();
+    int    collision;
+
+    if (path == NULL) {
+        fprintf(stderr, "--incremental needs a file, not stdin\n");
+        return -1;
+    }
+
+    if (incr_hash_file(path, digest, &collision) == INCR_FAILED)
+        return -1;
+
+    sha_hash_hex(digest, hex);
+    printf("%s  %s\n", hex, filename);
+
+    /* found in an earlier run: check_collision( ) won't see it */
+    if (collision && sha_dc_detected() == seen) {
+        fprintf(stderr, "collision attack detected in '%s'\n", filename);
+        return -1;
+    }
+
+    return 0;
+}
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  print_digest
+ *  Description:  Prints 'digest  path' for the file at path, the
+ *                default mode for named files.  The file is read
+ *                through opts->batch, so a file that can't be
+ *                opened or read is reported and the run goes on.
+ *                Returns 0 on success or -1 on failure.
+ * ==============================================================
+ */
+static int
+print_digest(struct options_s *opts, char *path)
+{
+    uint8 digest[DIGEST_SIZE];
+    char  hex[HEX_SIZE];
+
+    if (batch_hash_file(&opts->batch, path, digest) != 0)
+        return -1;
+
+    sha_hash_hex(digest, hex);
+    printf("%s  %s\n", hex, path);
+
+    return 0;
+}
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  check_collision
+ *  Description:  Reports filename if the sha1dc engine has found a
+ *                collision attack since its counter read seen.
+ *                The digest has already been printed by then; it
+ *                is the exit status that tells the caller not to
+ *                trust it.  Returns 0 if nothing was found or -1
+ *                if something was.
+ * ==============================================================
+ */
+static int
+check_collision(uint64 seen, char *filename)
+{
+    if (sha_dc_detected() == seen)
+        return 0;
+
+    fprintf(stderr, "collision attack detected in '%s'\n", filename);
+    return -1;
+}
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  run_tee
+ *  Description:  Copies src to dst ("-" meaning stdin and stdout)
+ *                and writes the digest of the data, in the
+ *                'digest  file' form, to the --sidecar file or to
+ *                stderr, which is free since stdout may be
+ *                carrying the data.  Returns 0 on success or -1 on
+ *                failure.
+ * ==============================================================
+ */
+static int
+run_tee(struct options_s *opts, char *src, char *dst)
+{
+    uint8  digest[DIGEST_SIZE];
+    char   hex[HEX_SIZE];
+    FILE  *out  = stderr;
+    uint64 seen = sha_dc_detected();
+
+    if (tee_file(strcmp(src, "-") == 0 ? NULL : src,
+                 strcmp(dst, "-") == 0 ? NULL : dst, digest) != 0)
+        return -1;
+
+    if (opts->sidecar && (out = fopen(opts->sidecar, "w")) == NULL) {
+        fprintf(stderr, "couldn't create file '%s'\n", opts->sidecar);
+        return -1;
+    }
+
+    sha_hash_hex(digest, hex);
+    fprintf(out, "%s  %s\n", hex, src);
+
+    if (out != stderr && fclose(out) != 0) {
+        fprintf(stderr, "error writing '%s'\n", opts->sidecar);
+        return -1;
+    }
+
+    return check_collision(seen, src);
+}
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  hash_one
+ *  Description:  Runs the selected mode on a single file given by
+ *                filename, where "-" means stdin.  Returns 0 on
+ *                success or -1 if a mode that reports errors per
+ *                file failed on it.
+ * ==============================================================
+ */
+static int
+hash_one(struct options_s *opts, char *filename)
+{
+    /* the library calls expect stdin as a NULL path */
+    char  *path = strcmp(filename, "-") == 0 ? NULL : filename;
+    uint64 seen = sha_dc_detected();
+    int    ret  = 0;
+
+    switch (opts->mode) {
+        case MODE_CHUNK:
+            ret = cdc_file(path, opts->min_size, opts->avg_size,
+                           opts->max_size, print_chunk, filename);
+            break;
+
+        case MODE_PIECES:
+            ret = print_pieces(path, filename, opts->piece_size,
+                               opts->nthreads, opts->binary);
+            break;
+
+        case MODE_GIT_BLOB:
+            ret = print_git_blob(path, filename);
+            break;
+
+        case MODE_CLIENT:
+            ret = print_client(opts, path, filename);
+            break;
+
+        case MODE_ALGOS:
+            ret = print_digests(opts, path, filename);
+            break;
+
+        case MODE_INCREMENTAL:
+            ret = print_incremental(path, filename);
+            break;
+
+        default:
+            if (path)
+                ret = print_digest(opts, path);
+            else
+                sha_hash_file_output(NULL);
+            break;
+    }
+
+    if (check_collision(seen, filename) != 0)
+        ret = -1;
+
+    return ret;
+}
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  hash_list
+ *  Description:  Runs the selected mode on every file named in
+ *                opts->files_from ("-" meaning stdin), each name
+ *                ended by opts->files_delim, so huge lists don't
+ *                have to fit on the command line.  A "-" entry
+ *                means stdin, unless the list is being read from
+ *                it.  Returns 0 if every file succeeded or -1
+ *                otherwise.
+ * ==============================================================
+ */
+static int
+hash_list(struct options_s *opts)
+{
+    FILE   *list = stdin;
+    char   *line = NULL;
+    size_t  size = 0;
+    ssize_t len;
+    int     ret  = 0;
+
+    if (strcmp(opts->files_from, "-") != 0
+            && (list = fopen(opts->files_from, "r")) == NULL) {
+        fprintf(stderr, "couldn't open file '%s'\n", opts->files_from);
+        return -1;
+    }
+
+    while ((len = getdelim(&line, &size, opts->files_delim, list)) != -1) {
+        if (len > 0 && line[len - 1] == opts->files_delim)
+            line[--len] = '\0';
+
+        if (len == 0)
+            continue;
+
+        /* stdin is the list itself, and hashing it would eat the
+         * names still to come */
+        if (list == stdin && strcmp(line, "-") == 0) {
+            fprintf(stderr, "can't hash '-': the file list is read "
+                            "from stdin\n");
+            ret = -1;
+            continue;
+        }
+
+        if (hash_one(opts, line) != 0)
+            ret = -1;
+    }
+
+    if (ferror(list)) {
+        fprintf(stderr, "error reading '%s'\n", opts->files_from);
+        ret = -1;
+    }
+
+    free(line);
+
+    if (list != stdin)
+        fclose(list);
+
+    return ret;
+}
+
 
 
 /* 
@@ -47,24 +788,209 @@
  *                message digest for.  If no comand line
  *                arguments are provided, the algorithm reads
  *                from stdin.
+ *
+ *                With --chunk, each file is split into
+ *                content-defined chunks instead and a record is
+ *                printed for every chunk.  With --pieces, the
+ *                same is done for fixed size pieces.  --git-blob
+ *                prints git object ids and --batch takes the
+ *                file names from stdin (--files-from and
+ *                --files0-from from a file).  --tee copies its input
+ *                through instead, hashing it on the way.
  * ==============================================================
  */
 int
 main(int argc, char *argv[])
 {
-    if (argc > 1 ) {
+    /* the members not named here (batch, arena, ...) start zeroed */
+    struct options_s opts = {
+        .mode        = MODE_HASH,
+        .min_size    = CDC_MIN_SIZE,
+        .avg_size    = CDC_AVG_SIZE,
+        .max_size    = CDC_MAX_SIZE,
+        .piece_size  = PIECE_DEFAULT_SIZE,
+        .files_delim = '\n',
+        .client_fd   = -1
+    };
 
-        while (argc > 1) {
-            sha_hash_file_output(argv[1]);
-            argc--;
-            argv++;
+    int opt;
+    int status = EXIT_SUCCESS;
+
+    while ((opt = getopt_long(argc, argv, "cpt:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'c':
+                opts.mode = MODE_CHUNK;
+                break;
+
+            case OPT_MIN_SIZE:
+                opts.min_size = parse_size(optarg);
+                break;
+
+            case OPT_AVG_SIZE:
+                opts.avg_size = parse_size(optarg);
+                break;
+
+            case OPT_MAX_SIZE:
+                opts.max_size = parse_size(optarg);
+                break;
+
+            case 'p':
+                opts.mode = MODE_PIECES;
+                break;
+
+            case OPT_PIECE_SIZE:
+                opts.piece_size = parse_size(optarg);
+                break;
+
+            case 't':
+                opts.nthreads = atoi(optarg);
+                break;
+
+            case OPT_BINARY:
+                opts.binary = 1;
+                break;
+
+            case OPT_GIT_BLOB:
+                opts.mode = MODE_GIT_BLOB;
+                break;
+
+            case OPT_BATCH:
+                opts.files_from  = "-";
+                opts.files_delim = '\n';
+                break;
+
+            case OPT_FILES_FROM:
+                opts.files_from  = optarg;
+                opts.files_delim = '\n';
+                break;
+
+            case OPT_FILES0_FROM:
+                opts.files_from  = optarg;
+                opts.files_delim = '\0';
+                break;
+
+            case OPT_STATS:
+                stats_enable();
+                break;
+
+            case OPT_SERVER:
+                opts.mode   = MODE_SERVER;
+                opts.server = optarg;
+                break;
+
+            case OPT_CLIENT:
+                opts.mode   = MODE_CLIENT;
+                opts.server = optarg;
+                break;
+
+            case OPT_ENGINE:
+                if (engine_select(optarg) != 0) {
+                    fprintf(stderr, "engine '%s' is not available\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case OPT_INCREMENTAL:
+                opts.mode = MODE_INCREMENTAL;
+                break;
+
+            case OPT_DETECT:
+                engine_select("sha1dc");
+                break;
+
+            case OPT_LIST_ENGINES:
+                engine_list(stdout);
+                return EXIT_SUCCESS;
+
+            case OPT_TEE:
+                opts.mode = MODE_TEE;
+                break;
+
+            case OPT_SIDECAR:
+                opts.sidecar = optarg;
+                break;
+
+            case OPT_ALGO:
+                opts.mode = MODE_ALGOS;
+                if (parse_algos(&opts, optarg) != 0)
+                    return EXIT_FAILURE;
+                break;
+
+            case 'h':
+                usage(stdout);
+                return EXIT_SUCCESS;
+
+            default:
+                usage(stderr);
+                return EXIT_FAILURE;
         }
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    /* only returns if the daemon couldn't be started */
+    if (opts.mode == MODE_SERVER) {
+        server_run(opts.server, opts.nthreads);
+        return EXIT_FAILURE;
+    }
+
+    if (opts.mode == MODE_TEE && argc > 2) {
+        usage(stderr);
+        return EXIT_FAILURE;
+    }
+
+    if (opts.mode == MODE_CLIENT) {
+        opts.client_fd = server_connect(opts.server);
+        if (opts.client_fd < 0)
+            return EXIT_FAILURE;
+    }
+
+    /* let a producer piping into us get further ahead; it changes
+     * the pipe for everyone on it, so the hashing code leaves it to
+     * the program */
+    pipeline_grow_pipe(STDIN_FILENO);
+
+    /* only --algo hashes on worker threads of its own; the daemon's
+     * workers keep their own arenas */
+    if (batch_init(&opts.batch) != 0
+            || (opts.mode == MODE_ALGOS && arena_init(&opts.arena) != 0)) {
+        fprintf(stderr, "out of memory\n");
+        return EXIT_FAILURE;
+    }
+
+    if (opts.mode == MODE_TEE) {
+        if (run_tee(&opts, argc > 0 ? argv[0] : "-",
+                    argc > 1 ? argv[1] : "-") != 0)
+            status = EXIT_FAILURE;
+
+    } else if (opts.files_from) {
+        if (hash_list(&opts) != 0)
+            status = EXIT_FAILURE;
+
+    /* no arguments means stdin */
+    } else if (argc == 0) {
+        if (hash_one(&opts, "-") != 0)
+            status = EXIT_FAILURE;
 
     } else {
+        while (argc > 0) {
+            if (hash_one(&opts, argv[0]) != 0)
+                status = EXIT_FAILURE;
 
-        sha_hash_file_output(NULL);
+            argc--;
+            argv++;
+        }
     }
 
+    batch_free(&opts.batch);
+    if (opts.mode == MODE_ALGOS)
+        arena_free(&opts.arena);
+
+    if (sha_stats_enabled) {
+        fflush(stdout);
+        stats_print_json(stderr);
+    }
 
-    return EXIT_SUCCESS;
+    return status;
 }
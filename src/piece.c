@@ -0,0 +1,450 @@
+/*
+ * ==============================================================
+ *       Filename:  piece.c
+ *
+ *    Description:  Fixed size piece hashing, as used for
+ *                  BitTorrent style piece lists.  Computes the
+ *                  SHA-1 msg digest of every piece of a file and
+ *                  of the whole file from a single read of it,
+ *                  hashing the pieces in parallel.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "piece.h"
+#include "engine.h"
+#include "stats.h"
+
+
+/* size of the reads used when the input can't be mapped */
+#define PIECE_BUF_SIZE  (64 * 1024)
+
+
+/* shared by the worker threads hashing a mapped file */
+struct piece_job_s {
+
+    const uint8          *data;   /* the mapped file */
+    struct piece_list_s  *list;
+    uint64                next;   /* next piece to hand out */
+    pthread_mutex_t       lock;   /* protects next */
+
+};
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  group_size
+ *  Description:  Returns how many pieces to hash together starting
+ *                at piece i: ENGINE_LANES if the engine has a
+ *                multi-lane kernel and that many full-size pieces
+ *                are left, 1 otherwise.
+ * ==============================================================
+ */
+static uint64
+group_size(const struct piece_list_s *list, uint64 i)
+{
+    if (engine_get()->compress_x4 != NULL
+            && (i + ENGINE_LANES) * list->piece_size <= list->length)
+        return ENGINE_LANES;
+
+    return 1;
+}		/* -----  end of static function group_size  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  hash_pieces
+ *  Description:  Computes the digests of the n pieces starting at
+ *                piece i of the mapped file pointed to by data and
+ *                stores them in their slots of list->digests.  n
+ *                is 1, or ENGINE_LANES full-size pieces, which are
+ *                hashed side by side with sha_hash_update_x4( ).
+ * ==============================================================
+ */
+static void
+hash_pieces(const uint8 *data, struct piece_list_s *list, uint64 i,
+            uint64 n)
+{
+    struct sha_hash_s  hash[ENGINE_LANES];
+    struct sha_hash_s *lanes[ENGINE_LANES];
+    const uint8       *bufs[ENGINE_LANES];
+    uint64 offset = i * list->piece_size;
+    uint64 len    = list->length - offset;
+    uint64 j;
+
+    if (len > list->piece_size)
+        len = list->piece_size;
+
+    if (n == 1) {
+        sha_hash_init(&hash[0]);
+        sha_hash_update(&hash[0], data + offset, len);
+        sha_hash_final(&hash[0], list->digests + i * DIGEST_SIZE);
+        return;
+    }
+
+    for (j = 0; j < ENGINE_LANES; j++) {
+        sha_hash_init(&hash[j]);
+        lanes[j] = &hash[j];
+        bufs[j]  = data + offset + j * list->piece_size;
+    }
+
+    sha_hash_update_x4(lanes, bufs, list->piece_size);
+
+    for (j = 0; j < ENGINE_LANES; j++)
+        sha_hash_final(&hash[j], list->digests + (i + j) * DIGEST_SIZE);
+
+}		/* -----  end of static function hash_pieces  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  piece_worker
+ *  Description:  Thread start routine.  Takes the next unhashed
+ *                piece (or group of pieces, see group_size( ))
+ *                from the job until there are none left.
+ *                Pieces are handed out in file order, so the
+ *                workers stay close to each other (and to the
+ *                whole-file pass) in the page cache.
+ * ==============================================================
+ */
+static void *
+piece_worker(void *arg)
+{
+    struct piece_job_s *job = arg;
+    uint64 i, n;
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        i = job->next;
+        n = group_size(job->list, i);
+        job->next += n;
+        pthread_mutex_unlock(&job->lock);
+
+        if (i >= job->list->count)
+            break;
+
+        hash_pieces(job->data, job->list, i, n);
+    }
+
+    return NULL;
+}		/* -----  end of static function piece_worker  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  hash_mapped
+ *  Description:  Hashes the regular file open on fd by mapping
+ *                it.  nthreads workers hash the pieces while the
+ *                calling thread computes the whole-file digest,
+ *                which can't be split up.  With a single thread
+ *                both digests are updated a piece at a time, so
+ *                each piece is still only brought into cache
+ *                once.
+ *
+ *                Returns 0 on success, or -1 if the file can't be
+ *                mapped (the caller then falls back to reading).
+ * ==============================================================
+ */
+static int
+hash_mapped(int fd, struct piece_list_s *list, int nthreads)
+{
+    struct sha_hash_s  whole;
+    struct piece_job_s job;
+    pthread_t *workers;
+    uint8     *data;
+    uint64     i, n;
+    int        started = 0;
+
+    data = mmap(NULL, list->length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+        return -1;
+
+    posix_madvise(data, list->length, POSIX_MADV_SEQUENTIAL);
+
+    sha_hash_init(&whole);
+
+    if (nthreads > 1 && list->count > 1) {
+
+        job.data = data;
+        job.list = list;
+        job.next = 0;
+        pthread_mutex_init(&job.lock, NULL);
+
+        workers = malloc(nthreads * sizeof(*workers));
+        if (workers == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+
+        for (started = 0; started < nthreads; started++) {
+            if (pthread_create(&workers[started], NULL, piece_worker, &job) != 0)
+                break;
+        }
+
+        sha_hash_update(&whole, data, list->length);
+
+        /* if no thread could be started the pieces are done here */
+        if (started == 0)
+            piece_worker(&job);
+
+        for (i = 0; i < (uint64) started; i++)
+            pthread_join(workers[i], NULL);
+
+        free(workers);
+        pthread_mutex_destroy(&job.lock);
+
+    } else {
+
+        for (i = 0; i < list->count; i += n) {
+            uint64 offset = i * list->piece_size;
+
+            n = group_size(list, i);
+            hash_pieces(data, list, i, n);
+            sha_hash_update(&whole, data + offset,
+                            i + n < list->count ? n * list->piece_size
+                                                : list->length - offset);
+        }
+    }
+
+    sha_hash_final(&whole, list->whole);
+
+    munmap(data, list->length);
+
+    return 0;
+}		/* -----  end of static function hash_mapped  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  hash_stream
+ *  Description:  Hashes fd (a pipe, stdin, or anything else that
+ *                can't be mapped) by reading it once, updating
+ *                the digest of the current piece and of the whole
+ *                input from the same buffer.  The length isn't
+ *                known up front, so list->digests grows as
+ *                pieces are completed.
+ *
+ *                Returns 0 on success or -1 on a read error.
+ * ==============================================================
+ */
+static int
+hash_stream(int fd, struct piece_list_s *list)
+{
+    struct sha_hash_s whole, piece;
+    uint8   buf[PIECE_BUF_SIZE];
+    uint8  *digests;
+    uint64  capacity = 0;
+    uint64  in_piece = 0;               /* bytes in the current piece */
+    ssize_t n;
+    size_t  off, len;
+
+    sha_hash_init(&whole);
+    sha_hash_init(&piece);
+
+    list->length = 0;
+    list->count  = 0;
+
+    for (;;) {
+        n = stats_read(fd, buf, sizeof(buf));
+
+        if (n < 0)
+            return -1;
+        if (n == 0)
+            break;
+
+        sha_hash_update(&whole, buf, n);
+        list->length += n;
+
+        for (off = 0; off < (size_t) n; off += len) {
+            len = n - off;
+            if (len > list->piece_size - in_piece)
+                len = list->piece_size - in_piece;
+
+            sha_hash_update(&piece, buf + off, len);
+            in_piece += len;
+
+            if (in_piece < list->piece_size)
+                continue;
+
+            /* the piece is complete; make room for its digest */
+            if (list->count == capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                digests  = realloc(list->digests, capacity * DIGEST_SIZE);
+                if (digests == NULL) {
+                    fprintf(stderr, "out of memory\n");
+                    exit(EXIT_FAILURE);
+                }
+                list->digests = digests;
+            }
+
+            sha_hash_final(&piece, list->digests + list->count * DIGEST_SIZE);
+            list->count++;
+
+            sha_hash_init(&piece);
+            in_piece = 0;
+        }
+    }
+
+    /* a short last piece */
+    if (in_piece > 0) {
+        digests = realloc(list->digests, (list->count + 1) * DIGEST_SIZE);
+        if (digests == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+        list->digests = digests;
+
+        sha_hash_final(&piece, list->digests + list->count * DIGEST_SIZE);
+        list->count++;
+    }
+
+    sha_hash_final(&whole, list->whole);
+
+    return 0;
+}		/* -----  end of static function hash_stream  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  piece_hash_file
+ *  Description:  API function to split the file given by
+ *                filename (or stdin if filename is NULL) into
+ *                pieces of piece_size bytes and fill in list with
+ *                the digest of every piece and of the whole file.
+ *                The file is only read once.  Up to nthreads
+ *                threads hash pieces in parallel; nthreads <= 0
+ *                uses one per online processor.
+ *
+ *                piece_size must be a power of two between
+ *                PIECE_MIN_SIZE and PIECE_MAX_SIZE.
+ *
+ *                Returns 0 on success or -1 on failure, after
+ *                printing the reason to stderr.  On success the
+ *                caller releases the list with piece_list_free( ).
+ * ==============================================================
+ */
+int
+piece_hash_file(char *filename, uint64 piece_size, int nthreads,
+                struct piece_list_s *list)
+{
+    struct stat st;
+    int fd;
+    int ret = -1;
+
+    if (piece_size < PIECE_MIN_SIZE || piece_size > PIECE_MAX_SIZE
+            || (piece_size & (piece_size - 1)) != 0) {
+        fprintf(stderr, "piece size must be a power of two between "
+                        "%d and %d\n", PIECE_MIN_SIZE, PIECE_MAX_SIZE);
+        return -1;
+    }
+
+    if (nthreads <= 0)
+        nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+    list->piece_size = piece_size;
+    list->length     = 0;
+    list->count      = 0;
+    list->digests    = NULL;
+
+    if (filename) {
+
+        fd = open(filename, O_RDONLY);
+
+        if (fd < 0) {
+            fprintf(stderr, "couldn't open file '%s'\n", filename);
+            return -1;
+        }
+
+    } else {
+
+        fd = STDIN_FILENO;
+    }
+
+    /* regular files are mapped and their pieces hashed in parallel */
+    if (filename && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)
+            && st.st_size > 0) {
+
+        list->length  = st.st_size;
+        list->count   = (list->length + piece_size - 1) / piece_size;
+        list->digests = malloc(list->count * DIGEST_SIZE);
+
+        if (list->digests == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(EXIT_FAILURE);
+        }
+
+        ret = hash_mapped(fd, list, nthreads);
+
+        if (ret != 0) {
+            free(list->digests);
+            list->digests = NULL;
+        }
+    }
+
+    if (ret != 0) {
+        ret = hash_stream(fd, list);
+
+        if (ret != 0) {
+            fprintf(stderr, "error reading '%s'\n", filename ? filename : "-");
+            piece_list_free(list);
+        }
+    }
+
+    if (filename)
+        close(fd);
+
+    return ret;
+}		/* -----  end of function piece_hash_file  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  piece_list_free
+ *  Description:  API function to release the digests held by a
+ *                list filled in by piece_hash_file( ).
+ * ==============================================================
+ */
+void
+piece_list_free(struct piece_list_s *list)
+{
+    free(list->digests);
+    list->digests = NULL;
+    list->count   = 0;
+}		/* -----  end of function piece_list_free  ----- */
@@ -0,0 +1,319 @@
+/*
+ * ==============================================================
+ *       Filename:  pipeline.c
+ *
+ *    Description:  Overlapped reading and hashing of a pipe.  A
+ *                  reader thread fills a ring of large buffers
+ *                  from the input while the calling thread works
+ *                  on the previous one, so neither waits for the
+ *                  other as long as a buffer is free.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+/* F_SETPIPE_SZ is Linux specific */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include "pipeline.h"
+#include "stats.h"
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  fill
+ *  Description:  Reads from pl->fd into buf.  Waits for the first
+ *                bytes, then keeps reading only as long as more
+ *                are ready at once, up to PIPELINE_BUF_SIZE: a
+ *                fast input fills whole buffers, while a slow one
+ *                is handed over as it trickles in instead of
+ *                waiting for a full buffer.  Gives up, returning
+ *                what it has, as soon as pipeline_finish( ) wakes
+ *                it.
+ *
+ *                Returns the number of bytes read; *status is set
+ *                to 1 at end of input and to the errno value on a
+ *                read error.
+ * ==============================================================
+ */
+static size_t
+fill(struct pipeline_s *pl, uint8 *buf, int *status)
+{
+    struct pollfd fds[2];
+    size_t  off = 0;
+    ssize_t n;
+
+    fds[0].fd     = pl->fd;
+    fds[0].events = POLLIN;
+    fds[1].fd     = pl->wake[0];
+    fds[1].events = POLLIN;
+
+    while (off < PIPELINE_BUF_SIZE) {
+        if (poll(fds, 2, off == 0 ? -1 : 0) < 0) {
+            if (errno == EINTR)
+                continue;
+            *status = errno;
+            break;
+        }
+
+        /* told to stop, or nothing more ready right now */
+        if (fds[1].revents != 0 || fds[0].revents == 0)
+            break;
+
+        n = stats_read(pl->fd, buf + off, PIPELINE_BUF_SIZE - off);
+
+        if (n < 0 && (errno == EINTR || errno == EAGAIN))
+            continue;
+
+        if (n <= 0) {
+            *status = n < 0 ? errno : 1;
+            break;
+        }
+
+        off += n;
+    }
+
+    return off;
+}		/* -----  end of static function fill  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  reader
+ *  Description:  Thread start routine.  Fills the free buffers of
+ *                the ring in order and hands each one to the
+ *                consumer, until the input ends or the consumer
+ *                stops.
+ * ==============================================================
+ */
+static void *
+reader(void *arg)
+{
+    struct pipeline_s *pl = arg;
+    uint8  *buf;
+    size_t  len;
+    int     status = 0;
+    int     stop;
+
+    while (status == 0) {
+        pthread_mutex_lock(&pl->lock);
+        while (pl->filled - pl->taken == PIPELINE_BUFS && !pl->stop)
+            pthread_cond_wait(&pl->cond, &pl->lock);
+        stop = pl->stop;
+        pthread_mutex_unlock(&pl->lock);
+
+        if (stop)
+            break;
+
+        /* the only buffer written outside the lock; the consumer
+         * can't have it until filled is bumped below */
+        buf = pl->data + (pl->filled % PIPELINE_BUFS) * PIPELINE_BUF_SIZE;
+        len = fill(pl, buf, &status);
+
+        pthread_mutex_lock(&pl->lock);
+        if (len > 0) {
+            pl->len[pl->filled % PIPELINE_BUFS] = len;
+            pl->filled++;
+        }
+        if (status != 0) {
+            pl->done  = 1;
+            pl->error = status == 1 ? 0 : status;
+        }
+        pthread_cond_broadcast(&pl->cond);
+        pthread_mutex_unlock(&pl->lock);
+    }
+
+    return NULL;
+}		/* -----  end of static function reader  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  pipeline_start
+ *  Description:  API function to start reading fd (normally a
+ *                pipe) in the background.  The buffers are read
+ *                into data, PIPELINE_SIZE bytes owned by the
+ *                caller (an arena's I/O buffer, say), or are
+ *                allocated if data is NULL.
+ *
+ *                Returns 0 on success, or -1 if the buffers or the
+ *                reader thread couldn't be had, in which case the
+ *                caller should read fd itself.
+ * ==============================================================
+ */
+int
+pipeline_start(struct pipeline_s *pl, int fd, uint8 *data)
+{
+    pl->fd    = fd;
+    pl->data  = data ? data : malloc(PIPELINE_SIZE);
+    pl->owned = data == NULL;
+
+    if (pl->data == NULL)
+        return -1;
+
+    /* pipeline_finish( ) writes to it to get the reader out of poll */
+    if (pipe(pl->wake) != 0) {
+        if (pl->owned)
+            free(pl->data);
+        return -1;
+    }
+
+    pl->filled  = 0;
+    pl->taken   = 0;
+    pl->holding = 0;
+    pl->done    = 0;
+    pl->error   = 0;
+    pl->stop    = 0;
+
+    pthread_mutex_init(&pl->lock, NULL);
+    pthread_cond_init(&pl->cond, NULL);
+
+    if (pthread_create(&pl->reader, NULL, reader, pl) != 0) {
+        pthread_cond_destroy(&pl->cond);
+        pthread_mutex_destroy(&pl->lock);
+        close(pl->wake[0]);
+        close(pl->wake[1]);
+        if (pl->owned)
+            free(pl->data);
+        return -1;
+    }
+
+    return 0;
+}		/* -----  end of function pipeline_start  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  pipeline_next
+ *  Description:  API function to hand back the buffer returned by
+ *                the previous call (if any) and wait for the next
+ *                filled one.  On return *buf points to it; it
+ *                stays valid until the next call or
+ *                pipeline_finish( ).
+ *
+ *                Returns the number of bytes in *buf, 0 at end of
+ *                input, or -1 on a read error (with errno set to
+ *                the reader's).
+ * ==============================================================
+ */
+ssize_t
+pipeline_next(struct pipeline_s *pl, const uint8 **buf)
+{
+    ssize_t len;
+
+    pthread_mutex_lock(&pl->lock);
+
+    if (pl->holding) {
+        pl->taken++;
+        pl->holding = 0;
+        pthread_cond_broadcast(&pl->cond);
+    }
+
+    while (pl->filled == pl->taken && !pl->done)
+        pthread_cond_wait(&pl->cond, &pl->lock);
+
+    if (pl->filled == pl->taken) {
+        len = 0;
+        if (pl->error) {
+            errno = pl->error;
+            len   = -1;
+        }
+    } else {
+        *buf = pl->data + (pl->taken % PIPELINE_BUFS) * PIPELINE_BUF_SIZE;
+        len  = pl->len[pl->taken % PIPELINE_BUFS];
+        pl->holding = 1;
+    }
+
+    pthread_mutex_unlock(&pl->lock);
+
+    return len;
+}		/* -----  end of function pipeline_next  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  pipeline_finish
+ *  Description:  API function to stop the reader, wait for it and
+ *                release the buffers.  If the input hasn't been
+ *                read to the end, the reader is woken from waiting
+ *                on it, so this doesn't hang on a pipe whose
+ *                writer has stalled.
+ * ==============================================================
+ */
+void
+pipeline_finish(struct pipeline_s *pl)
+{
+    ssize_t n;
+
+    pthread_mutex_lock(&pl->lock);
+    pl->stop = 1;
+    pthread_cond_broadcast(&pl->cond);
+    pthread_mutex_unlock(&pl->lock);
+
+    do
+        n = write(pl->wake[1], "", 1);
+    while (n < 0 && errno == EINTR);
+
+    pthread_join(pl->reader, NULL);
+
+    close(pl->wake[0]);
+    close(pl->wake[1]);
+    pthread_cond_destroy(&pl->cond);
+    pthread_mutex_destroy(&pl->lock);
+    if (pl->owned)
+        free(pl->data);
+    pl->data = NULL;
+}		/* -----  end of function pipeline_finish  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  pipeline_grow_pipe
+ *  Description:  Enlarges the kernel buffer of the pipe fd to
+ *                PIPELINE_BUF_SIZE where the system allows it, so
+ *                its writer can get further ahead between reads.
+ *                Changes the pipe for everyone using it, so only
+ *                the program itself calls it, on its own stdin;
+ *                pipeline_start( ) doesn't.
+ * ==============================================================
+ */
+void
+pipeline_grow_pipe(int fd)
+{
+#ifdef F_SETPIPE_SZ
+    /* best effort: fails for non-pipes or above pipe-max-size */
+    fcntl(fd, F_SETPIPE_SZ, PIPELINE_BUF_SIZE);
+#else
+    (void) fd;
+#endif
+}		/* -----  end of function pipeline_grow_pipe  ----- */
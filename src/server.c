@@ -0,0 +1,1073 @@
+/*
+ * ==============================================================
+ *       Filename:  server.c
+ *
+ *    Description:  Long running hashing daemon.  Listens on a
+ *                  local Unix domain socket and answers path or
+ *                  inline buffer requests with their SHA-1 msg
+ *                  digests, keeping its worker threads, buffers
+ *                  and a digest cache warm between requests.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "server.h"
+#include "arena.h"
+#include "engine.h"
+#include "pipeline.h"
+
+
+#define FRAME_HDR_SIZE  9         /* u32 length, u32 id, u8 type/status */
+
+/* a worker's read buffer; big enough to be a pipeline's ring too */
+#define SERVER_IO_SIZE  PIPELINE_SIZE
+
+
+/* one client connection.  It is shared by its reader thread and by
+ * every job it has queued, and closed when the last of them is done */
+struct conn_s {
+
+    int             fd;
+    int             refs;
+    int             jobs;         /* queued or running requests */
+    uint64          bytes;        /* and their payload bytes */
+    pthread_mutex_t lock;         /* protects the above, serializes
+                                     replies */
+    pthread_cond_t  room;         /* signaled as requests finish */
+    int             dead;         /* a reply couldn't be sent: no more
+                                     are, and the reader stops */
+
+};
+
+/* one request waiting for a worker */
+struct job_s {
+
+    struct conn_s  *conn;
+    uint32          id;
+    int             type;
+    uint8          *payload;      /* '\0' terminated, for REQ_PATH */
+    uint32          len;
+    int             done;         /* digest already computed, by
+                                     hash_lanes( ) */
+    uint8           digest[DIGEST_SIZE];
+    struct job_s   *next;
+
+};
+
+/* remembers the digest of a file by its identity, mtime and ctime */
+struct cache_entry_s {
+
+    int     valid;
+    dev_t   dev;
+    ino_t   ino;
+    off_t   size;
+    time_t  mtime_sec;
+    long    mtime_nsec;
+    time_t  ctime_sec;
+    long    ctime_nsec;
+    uint8   digest[DIGEST_SIZE];
+
+};
+
+
+/******************** GLOBAL VARIABLES *************************/
+
+/* requests waiting for a worker, oldest first */
+static struct job_s    *queue_head = NULL;
+static struct job_s    *queue_tail = NULL;
+static pthread_mutex_t  queue_lock  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   queue_ready = PTHREAD_COND_INITIALIZER;
+
+/* digests of recently hashed files */
+static struct cache_entry_s cache[SERVER_CACHE_SIZE];
+static pthread_mutex_t      cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* removed again when the server is told to stop */
+static const char *socket_path = NULL;
+
+/**************************************************************/
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  put_uint32
+ *  Description:  Stores word at buf, most significant byte
+ *                first.
+ * ==============================================================
+ */
+static void
+put_uint32(uint8 *buf, uint32 word)
+{
+    buf[0] = word >> 24;
+    buf[1] = (word >> 16) & 0xFF;
+    buf[2] = (word >>  8) & 0xFF;
+    buf[3] = word & 0xFF;
+}		/* -----  end of static function put_uint32  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  get_uint32
+ *  Description:  Returns the big-endian word stored at buf.
+ * ==============================================================
+ */
+static uint32
+get_uint32(const uint8 *buf)
+{
+    return ((uint32) buf[0] << 24) | ((uint32) buf[1] << 16)
+         | ((uint32) buf[2] <<  8) |  (uint32) buf[3];
+}		/* -----  end of static function get_uint32  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  read_full
+ *  Description:  Reads exactly len bytes from fd into buf.
+ *                Returns 0 on success or -1 on an error or if the
+ *                peer closed the connection first.
+ * ==============================================================
+ */
+static int
+read_full(int fd, void *buf, size_t len)
+{
+    uint8  *p = buf;
+    ssize_t n;
+
+    while (len > 0) {
+        n = read(fd, p, len);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return -1;
+
+        p   += n;
+        len -= n;
+    }
+
+    return 0;
+}		/* -----  end of static function read_full  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  write_full
+ *  Description:  Writes exactly len bytes from buf to the socket
+ *                fd.  A peer that went away is reported as an
+ *                error rather than with SIGPIPE.  With wait_ms >= 0
+ *                it never blocks for longer than that on a full
+ *                socket buffer, and fails if no room is made in
+ *                time; with wait_ms < 0 it blocks as long as it
+ *                takes.
+ * ==============================================================
+ */
+static int
+write_full(int fd, const void *buf, size_t len, int wait_ms)
+{
+    const uint8 *p = buf;
+    struct pollfd pfd;
+    int     flags = MSG_NOSIGNAL | (wait_ms >= 0 ? MSG_DONTWAIT : 0);
+    ssize_t n;
+
+    pfd.fd     = fd;
+    pfd.events = POLLOUT;
+
+    while (len > 0) {
+        n = send(fd, p, len, flags);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (poll(&pfd, 1, wait_ms) > 0 || errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (n < 0)
+            return -1;
+
+        p   += n;
+        len -= n;
+    }
+
+    return 0;
+}		/* -----  end of static function write_full  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  write_frame
+ *  Description:  Sends one frame (request or reply) of the wire
+ *                format described in server.h, waiting for room
+ *                as write_full( ) does.
+ * ==============================================================
+ */
+static int
+write_frame(int fd, uint32 id, int code, const void *payload, uint32 len,
+            int wait_ms)
+{
+    uint8 hdr[FRAME_HDR_SIZE];
+
+    put_uint32(hdr, len + 5);
+    put_uint32(hdr + 4, id);
+    hdr[8] = (uint8) code;
+
+    if (write_full(fd, hdr, sizeof(hdr), wait_ms) != 0)
+        return -1;
+
+    return write_full(fd, payload, len, wait_ms);
+}		/* -----  end of static function write_frame  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  conn_put
+ *  Description:  Drops one reference to conn, closing and freeing
+ *                it when it was the last.
+ * ==============================================================
+ */
+static void
+conn_put(struct conn_s *conn)
+{
+    int last;
+
+    pthread_mutex_lock(&conn->lock);
+    last = (--conn->refs == 0);
+    pthread_mutex_unlock(&conn->lock);
+
+    if (last) {
+        close(conn->fd);
+        pthread_cond_destroy(&conn->room);
+        pthread_mutex_destroy(&conn->lock);
+        free(conn);
+    }
+}		/* -----  end of static function conn_put  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  conn_reserve, conn_release
+ *  Description:  conn_reserve( ) waits until conn has room for one
+ *                more request of len payload bytes (see
+ *                SERVER_CONN_JOBS and SERVER_CONN_BYTES), then
+ *                accounts for it and takes a reference for its
+ *                job.  While it waits, nothing more is read from
+ *                the client, which pushes back on it through the
+ *                socket.  conn_release( ) undoes it when the
+ *                request is done.
+ * ==============================================================
+ */
+static void
+conn_reserve(struct conn_s *conn, uint32 len)
+{
+    pthread_mutex_lock(&conn->lock);
+
+    while (conn->jobs >= SERVER_CONN_JOBS
+            || conn->bytes + len > SERVER_CONN_BYTES)
+        pthread_cond_wait(&conn->room, &conn->lock);
+
+    conn->jobs++;
+    conn->bytes += len;
+    conn->refs++;
+
+    pthread_mutex_unlock(&conn->lock);
+}		/* -----  end of static function conn_reserve  ----- */
+
+static void
+conn_release(struct conn_s *conn, uint32 len)
+{
+    pthread_mutex_lock(&conn->lock);
+
+    conn->jobs--;
+    conn->bytes -= len;
+    pthread_cond_signal(&conn->room);
+
+    pthread_mutex_unlock(&conn->lock);
+
+    conn_put(conn);
+}		/* -----  end of static function conn_release  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  cache_slot
+ *  Description:  Returns the cache slot for the file described by
+ *                st.  The cache is direct mapped; a newer file
+ *                simply evicts whatever shared its slot.
+ * ==============================================================
+ */
+static struct cache_entry_s *
+cache_slot(const struct stat *st)
+{
+    uint64 key = ((uint64) st->st_dev * 0x9E3779B97F4A7C15ULL)
+               ^ ((uint64) st->st_ino * 0xC2B2AE3D27D4EB4FULL);
+
+    return &cache[(key >> 32) % SERVER_CACHE_SIZE];
+}		/* -----  end of static function cache_slot  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  cache_lookup
+ *  Description:  Copies the cached digest of the file described
+ *                by st into digest.  Returns 1 on a hit, 0 if the
+ *                file isn't cached or has changed since.
+ * ==============================================================
+ */
+static int
+cache_lookup(const struct stat *st, uint8 *digest)
+{
+    struct cache_entry_s *e = cache_slot(st);
+    int hit;
+
+    pthread_mutex_lock(&cache_lock);
+
+    hit = e->valid && e->dev == st->st_dev && e->ino == st->st_ino
+       && e->size == st->st_size
+       && e->mtime_sec  == st->st_mtim.tv_sec
+       && e->mtime_nsec == st->st_mtim.tv_nsec
+       && e->ctime_sec  == st->st_ctim.tv_sec
+       && e->ctime_nsec == st->st_ctim.tv_nsec;
+
+    if (hit)
+        memcpy(digest, e->digest, DIGEST_SIZE);
+
+    pthread_mutex_unlock(&cache_lock);
+
+    return hit;
+}		/* -----  end of static function cache_lookup  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  cache_store
+ *  Description:  Remembers digest for the file described by st.
+ * ==============================================================
+ */
+static void
+cache_store(const struct stat *st, const uint8 *digest)
+{
+    struct cache_entry_s *e = cache_slot(st);
+
+    pthread_mutex_lock(&cache_lock);
+
+    e->valid      = 1;
+    e->dev        = st->st_dev;
+    e->ino        = st->st_ino;
+    e->size       = st->st_size;
+    e->mtime_sec  = st->st_mtim.tv_sec;
+    e->mtime_nsec = st->st_mtim.tv_nsec;
+    e->ctime_sec  = st->st_ctim.tv_sec;
+    e->ctime_nsec = st->st_ctim.tv_nsec;
+    memcpy(e->digest, digest, DIGEST_SIZE);
+
+    pthread_mutex_unlock(&cache_lock);
+}		/* -----  end of static function cache_store  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  hash_path
+ *  Description:  Computes the digest of the file at path, using
+ *                the cache when the file hasn't changed since it
+ *                was last hashed.  The context and the read buffer
+ *                come from the worker's arena.  Only regular files
+ *                are hashed: the file is opened without blocking
+ *                and checked first, so a FIFO or device can't tie
+ *                up the worker.  Returns 0 on success, or -1 with
+ *                a message in err on failure.
+ * ==============================================================
+ */
+static int
+hash_path(const char *path, struct arena_s *arena, uint8 *digest,
+          char *err, size_t err_len)
+{
+    struct sha_hash_s *hash;
+    struct stat before, after;
+    long long n;
+    uint8 *buf;
+    int fd;
+
+    fd = open(path, O_RDONLY | O_NONBLOCK);
+
+    if (fd < 0) {
+        snprintf(err, err_len, "couldn't open file '%s': %s", path,
+                 strerror(errno));
+        return -1;
+    }
+
+    if (fstat(fd, &before) != 0) {
+        snprintf(err, err_len, "couldn't stat '%s'", path);
+        close(fd);
+        return -1;
+    }
+
+    if (!S_ISREG(before.st_mode)) {
+        snprintf(err, err_len, "'%s' is not a regular file", path);
+        close(fd);
+        return -1;
+    }
+
+    if (cache_lookup(&before, digest)) {
+        close(fd);
+        return 0;
+    }
+
+    hash = arena_ctx(arena, sizeof(*hash));
+    buf  = arena_io(arena, SERVER_IO_SIZE);
+
+    if (hash == NULL || buf == NULL) {
+        snprintf(err, err_len, "out of memory hashing '%s'", path);
+        close(fd);
+        return -1;
+    }
+
+    sha_hash_init(hash);
+
+    n = sha_hash_update_fd_buf(hash, fd, buf, SERVER_IO_SIZE);
+
+    if (n < 0) {
+        snprintf(err, err_len, "error reading '%s'", path);
+        close(fd);
+        return -1;
+    }
+
+    sha_hash_final(hash, digest);
+
+    if (hash->collision) {
+        snprintf(err, err_len, "collision attack detected in '%s'", path);
+        close(fd);
+        return -1;
+    }
+
+    /* only cache files that didn't change while they were read */
+    if (fstat(fd, &after) == 0
+            && after.st_size == before.st_size
+            && after.st_mtim.tv_sec  == before.st_mtim.tv_sec
+            && after.st_mtim.tv_nsec == before.st_mtim.tv_nsec
+            && after.st_ctim.tv_sec  == before.st_ctim.tv_sec
+            && after.st_ctim.tv_nsec == before.st_ctim.tv_nsec) {
+        cache_store(&before, digest);
+    }
+
+    close(fd);
+
+    return 0;
+}		/* -----  end of static function hash_path  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  run_job
+ *  Description:  Hashes what job asks for, with memory from the
+ *                worker's arena, and sends the reply on its
+ *                connection.  Replies from different workers to
+ *                the same connection are serialized by the
+ *                connection's lock.  A reply that finds no room in
+ *                the client's socket buffer for SERVER_SEND_WAIT ms
+ *                drops the connection.
+ * ==============================================================
+ */
+static void
+run_job(struct job_s *job, struct arena_s *arena)
+{
+    struct sha_hash_s *hash;
+    uint8 digest[DIGEST_SIZE];
+    char  err[256];
+    int   ok = 1;
+
+    arena_reset(arena);
+
+    if (job->done) {
+        memcpy(digest, job->digest, DIGEST_SIZE);
+
+    } else if (job->type == REQ_BUF) {
+        if ((hash = arena_ctx(arena, sizeof(*hash))) == NULL) {
+            snprintf(err, sizeof(err), "out of memory");
+            ok = 0;
+
+        } else {
+            sha_hash_init(hash);
+            sha_hash_update(hash, job->payload, job->len);
+            sha_hash_final(hash, digest);
+
+            if (hash->collision) {
+                snprintf(err, sizeof(err), "collision attack detected");
+                ok = 0;
+            }
+        }
+
+    } else if (job->type == REQ_PATH) {
+        ok = hash_path((char *) job->payload, arena, digest, err,
+                       sizeof(err)) == 0;
+
+    } else {
+        snprintf(err, sizeof(err), "unknown request type %d", job->type);
+        ok = 0;
+    }
+
+    pthread_mutex_lock(&job->conn->lock);
+
+    /* a client that doesn't read its replies is dropped rather than
+     * let it hold this worker, and so every other client, up */
+    if (!job->conn->dead
+            && (ok ? write_frame(job->conn->fd, job->id, REPLY_OK, digest,
+                                 DIGEST_SIZE, SERVER_SEND_WAIT)
+                   : write_frame(job->conn->fd, job->id, REPLY_ERR, err,
+                                 strlen(err), SERVER_SEND_WAIT)) != 0) {
+        job->conn->dead = 1;
+        shutdown(job->conn->fd, SHUT_RDWR);
+    }
+
+    pthread_mutex_unlock(&job->conn->lock);
+
+}		/* -----  end of static function run_job  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  hash_lanes
+ *  Description:  Computes the digests of the inline buffer jobs in
+ *                batch that can share the engine's multi-lane
+ *                kernel: groups of ENGINE_LANES buffers of the same
+ *                length (at least a block), as clients hashing
+ *                fixed size records send.  Each gets its digest
+ *                and done set; run_job( ) does the rest one by
+ *                one.  Does nothing if the engine has no such
+ *                kernel.
+ * ==============================================================
+ */
+static void
+hash_lanes(struct job_s *batch)
+{
+    struct sha_hash_s  hash[ENGINE_LANES];
+    struct sha_hash_s *lanes[ENGINE_LANES];
+    const uint8       *bufs[ENGINE_LANES];
+    struct job_s      *group[ENGINE_LANES];
+    struct job_s      *job, *other;
+    int n, i;
+
+    if (engine_get()->compress_x4 == NULL)
+        return;
+
+    for (job = batch; job != NULL; job = job->next) {
+        if (job->type != REQ_BUF || job->done || job->len < BLK_SIZE)
+            continue;
+
+        group[0] = job;
+        n = 1;
+
+        for (other = job->next; other != NULL && n < ENGINE_LANES;
+                other = other->next) {
+            if (other->type == REQ_BUF && !other->done
+                    && other->len == job->len)
+                group[n++] = other;
+        }
+
+        if (n < ENGINE_LANES)
+            continue;
+
+        for (i = 0; i < ENGINE_LANES; i++) {
+            sha_hash_init(&hash[i]);
+            lanes[i] = &hash[i];
+            bufs[i]  = group[i]->payload;
+        }
+
+        sha_hash_update_x4(lanes, bufs, job->len);
+
+        for (i = 0; i < ENGINE_LANES; i++) {
+            sha_hash_final(&hash[i], group[i]->digest);
+            group[i]->done = 1;
+        }
+    }
+}		/* -----  end of static function hash_lanes  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  worker
+ *  Description:  Thread start routine for the worker pool.  Takes
+ *                up to SERVER_BATCH queued jobs per trip through
+ *                the queue lock, so a burst of small requests
+ *                doesn't turn into a lock handoff per request,
+ *                then runs them back to back, equal sized inline
+ *                buffers four at a time (see hash_lanes( )).  Workers live as
+ *                long as the server, and so does each one's
+ *                arena, so after its first file a worker hashes
+ *                without allocating.
+ * ==============================================================
+ */
+static void *
+worker(void *arg)
+{
+    struct job_s  *batch, *job;
+    struct arena_s arena;
+    int n;
+
+    (void) arg;
+
+    if (arena_init(&arena) != 0) {
+        fprintf(stderr, "out of memory\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&queue_lock);
+
+        while (queue_head == NULL)
+            pthread_cond_wait(&queue_ready, &queue_lock);
+
+        batch = queue_head;
+        job   = batch;
+        for (n = 1; n < SERVER_BATCH && job->next != NULL; n++)
+            job = job->next;
+
+        queue_head = job->next;
+        if (queue_head == NULL)
+            queue_tail = NULL;
+        job->next = NULL;
+
+        pthread_mutex_unlock(&queue_lock);
+
+        hash_lanes(batch);
+
+        while (batch != NULL) {
+            job   = batch;
+            batch = batch->next;
+
+            run_job(job, &arena);
+
+            conn_release(job->conn, job->len);
+            free(job->payload);
+            free(job);
+        }
+    }
+
+    return NULL;
+}		/* -----  end of static function worker  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  reader
+ *  Description:  Thread start routine for one connection.  Reads
+ *                request frames and queues them for the workers
+ *                until the client closes the connection or sends
+ *                a malformed frame.  Room for each request is
+ *                reserved before its payload is read, so a client
+ *                can't make the server hold more than
+ *                SERVER_CONN_BYTES of its payloads at once.
+ * ==============================================================
+ */
+static void *
+reader(void *arg)
+{
+    struct conn_s *conn = arg;
+    struct job_s  *job;
+    uint8  hdr[FRAME_HDR_SIZE];
+    uint32 len;
+
+    for (;;) {
+        if (read_full(conn->fd, hdr, sizeof(hdr)) != 0)
+            break;
+
+        len = get_uint32(hdr);
+        if (len < 5 || len - 5 > SERVER_MAX_FRAME)
+            break;
+
+        len -= 5;
+
+        conn_reserve(conn, len);
+
+        job = malloc(sizeof(*job));
+        if (job == NULL) {
+            conn_release(conn, len);
+            break;
+        }
+
+        job->conn    = conn;
+        job->id      = get_uint32(hdr + 4);
+        job->type    = hdr[8];
+        job->len     = len;
+        job->done    = 0;
+        job->next    = NULL;
+        job->payload = malloc(job->len + 1);
+
+        if (job->payload == NULL
+                || read_full(conn->fd, job->payload, job->len) != 0) {
+            free(job->payload);
+            free(job);
+            conn_release(conn, len);
+            break;
+        }
+
+        job->payload[job->len] = '\0';
+
+        pthread_mutex_lock(&queue_lock);
+        if (queue_tail)
+            queue_tail->next = job;
+        else
+            queue_head = job;
+        queue_tail = job;
+        pthread_cond_signal(&queue_ready);
+        pthread_mutex_unlock(&queue_lock);
+    }
+
+    conn_put(conn);
+
+    return NULL;
+}		/* -----  end of static function reader  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  stop
+ *  Description:  SIGINT/SIGTERM handler.  Removes the socket so
+ *                the next server can bind it, then exits.
+ * ==============================================================
+ */
+static void
+stop(int sig)
+{
+    (void) sig;
+
+    if (socket_path)
+        unlink(socket_path);
+
+    _exit(EXIT_SUCCESS);
+}		/* -----  end of static function stop  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  clear_stale
+ *  Description:  Makes way for a new socket at path, sun being
+ *                its address: removes it only if it is a socket
+ *                nobody listens on any more (connect(2) is
+ *                refused), as a server that was killed leaves
+ *                behind.  Anything else there, a file or a live
+ *                server, is left alone.  Returns 0 if the path is
+ *                now free or -1 after saying why it isn't.
+ * ==============================================================
+ */
+static int
+clear_stale(const char *path, const struct sockaddr_un *sun)
+{
+    struct stat st;
+    int fd, err;
+
+    if (lstat(path, &st) != 0) {
+        if (errno == ENOENT)
+            return 0;
+        fprintf(stderr, "couldn't stat '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    if (!S_ISSOCK(st.st_mode)) {
+        fprintf(stderr, "'%s' exists and is not a socket\n", path);
+        return -1;
+    }
+
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    err = connect(fd, (const struct sockaddr *) sun, sizeof(*sun)) == 0
+        ? 0 : errno;
+    close(fd);
+
+    if (err == 0) {
+        fprintf(stderr, "a server is already listening on '%s'\n", path);
+        return -1;
+    }
+
+    if (err != ECONNREFUSED) {
+        fprintf(stderr, "couldn't check socket '%s': %s\n", path,
+                strerror(err));
+        return -1;
+    }
+
+    if (unlink(path) != 0 && errno != ENOENT) {
+        fprintf(stderr, "couldn't remove stale socket '%s': %s\n", path,
+                strerror(errno));
+        return -1;
+    }
+
+    return 0;
+}		/* -----  end of static function clear_stale  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  server_run
+ *  Description:  API function to serve hashing requests on the
+ *                Unix domain socket at sock_path (replacing a
+ *                stale socket there, see clear_stale( )) with a
+ *                pool of nthreads workers; nthreads <= 0 uses one
+ *                per online processor.  Each connection gets a thread that
+ *                reads its requests into the shared queue.
+ *
+ *                Only returns, with -1, if the server can't be
+ *                started; otherwise it runs until SIGINT or
+ *                SIGTERM.
+ * ==============================================================
+ */
+int
+server_run(const char *sock_path, int nthreads)
+{
+    struct sockaddr_un addr;
+    struct sigaction   sa;
+    struct conn_s     *conn;
+    pthread_attr_t     attr;
+    pthread_t          tid;
+    int listen_fd, fd, i;
+
+    if (strlen(sock_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "socket path '%s' is too long\n", sock_path);
+        return -1;
+    }
+
+    if (nthreads <= 0)
+        nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, sock_path);
+
+    if (clear_stale(sock_path, &addr) != 0) {
+        close(listen_fd);
+        return -1;
+    }
+
+    if (bind(listen_fd, (struct sockaddr *) &addr, sizeof(addr)) != 0
+            || listen(listen_fd, SOMAXCONN) != 0) {
+        fprintf(stderr, "couldn't listen on '%s': %s\n", sock_path,
+                strerror(errno));
+        close(listen_fd);
+        return -1;
+    }
+
+    socket_path = sock_path;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = stop;
+    sigaction(SIGINT,  &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sa, NULL);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+    for (i = 0; i < nthreads; i++) {
+        if (pthread_create(&tid, &attr, worker, NULL) != 0) {
+            fprintf(stderr, "couldn't start worker threads\n");
+            unlink(sock_path);
+            return -1;
+        }
+    }
+
+    for (;;) {
+        fd = accept(listen_fd, NULL, NULL);
+
+        if (fd < 0) {
+            if (errno != EINTR && errno != ECONNABORTED)
+                perror("accept");
+            continue;
+        }
+
+        conn = malloc(sizeof(*conn));
+        if (conn == NULL) {
+            close(fd);
+            continue;
+        }
+
+        conn->fd    = fd;
+        conn->refs  = 1;                  /* held by the reader */
+        conn->jobs  = 0;
+        conn->bytes = 0;
+        conn->dead  = 0;
+        pthread_mutex_init(&conn->lock, NULL);
+        pthread_cond_init(&conn->room, NULL);
+
+        if (pthread_create(&tid, &attr, reader, conn) != 0) {
+            pthread_cond_destroy(&conn->room);
+            pthread_mutex_destroy(&conn->lock);
+            close(fd);
+            free(conn);
+        }
+    }
+
+    return -1;
+}		/* -----  end of function server_run  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  server_connect
+ *  Description:  API function to connect to a server listening on
+ *                sock_path.  Returns the connected socket, or -1
+ *                after printing the reason to stderr.
+ * ==============================================================
+ */
+int
+server_connect(const char *sock_path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(sock_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "socket path '%s' is too long\n", sock_path);
+        return -1;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, sock_path);
+
+    if (connect(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "couldn't connect to '%s': %s\n", sock_path,
+                strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}		/* -----  end of function server_connect  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  server_request
+ *  Description:  API function to send one request of the given
+ *                type to the server connected on fd and wait for
+ *                its reply.  Intended for simple clients that
+ *                don't pipeline: replies to other ids are
+ *                skipped.
+ *
+ *                Returns 0 and fills in digest on success, or -1
+ *                with the server's (or a transport) error message
+ *                in err.
+ * ==============================================================
+ */
+int
+server_request(int fd, uint32 id, int type, const void *payload,
+               uint32 len, uint8 *digest, char *err, size_t err_len)
+{
+    uint8  hdr[FRAME_HDR_SIZE];
+    uint8 *reply;
+    uint32 rlen;
+    int    ret = -1;
+
+    if (len > SERVER_MAX_FRAME) {
+        snprintf(err, err_len, "request too large");
+        return -1;
+    }
+
+    if (write_frame(fd, id, type, payload, len, -1) != 0) {
+        snprintf(err, err_len, "couldn't send request");
+        return -1;
+    }
+
+    for (;;) {
+        if (read_full(fd, hdr, sizeof(hdr)) != 0
+                || (rlen = get_uint32(hdr)) < 5) {
+            snprintf(err, err_len, "connection to server lost");
+            return -1;
+        }
+
+        rlen -= 5;
+        reply = malloc(rlen + 1);
+
+        if (reply == NULL || read_full(fd, reply, rlen) != 0) {
+            free(reply);
+            snprintf(err, err_len, "connection to server lost");
+            return -1;
+        }
+
+        if (get_uint32(hdr + 4) == id)
+            break;
+
+        free(reply);
+    }
+
+    if (hdr[8] == REPLY_OK && rlen == DIGEST_SIZE) {
+        memcpy(digest, reply, DIGEST_SIZE);
+        ret = 0;
+
+    } else {
+        reply[rlen] = '\0';
+        snprintf(err, err_len, "%s", (char *) reply);
+    }
+
+    free(reply);
+
+    return ret;
+}		/* -----  end of function server_request  ----- */
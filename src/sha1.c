@@ -43,9 +43,22 @@
  * ==============================================================
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "sha1.h"
+#include "engine.h"
+#include "pipeline.h"
+#include "stats.h"
+
+
+/* size of the buffer handed to sha_hash_update( ) when reading
+ * from a file or stdin by sha_hash_update_fd( ) */
+#define IO_BUF_SIZE  (64 * 1024)
 
 
 
@@ -67,19 +80,27 @@ process_str(struct sha_hash_s *hash, char *str);
 
 
 static void
-compute_hash(struct sha_hash_s *hash);
+compute_hash(struct sha_hash_s *hash, const uint8 *block);
 
 
 static char *
 get_digest(struct sha_hash_s *hash);
 
+
+static void
+add_length(struct sha_hash_s *hash, size_t len);
+
+
+static void
+compress_blocks(struct sha_hash_s *hash, const uint8 *blocks, size_t nblocks);
+
 /***************** END FUNCTION PROTOTYPES *********************/
 
 
 /******************** GLOBAL VARIABLES *************************/
 
-/* Array for final sha1 hash  */
-static char sha1hash[40] = { 0x00 };
+/* Array for final sha1 hash (plus the terminating null) */
+static char sha1hash[HEX_SIZE] = { 0x00 };
 
 /* Constants K sub t */
 static uint32 k[ ] = { 0x5A827999,      /* K for  0 <= t <= 19 */
@@ -244,15 +265,15 @@ get_uint8(uint32 word, int byte_num)
  * ==============================================================
  */
 static void
-print_block(struct sha_hash_s *hash)
+print_block(struct sha_hash_s *hash, const uint8 *block)
 {
     char hex_str[] = "00";
     puts("Output of a 64 byte (512 bits) msg block in HEX:\n");
     printf("length of orig msg (so far) is %d bits\n", hash->lo_length);
 
     int i;
-    for(i = 0; i < (hash->msg_idx); i++) {
-        hexdump_char(hash->msg_block[i], hex_str);
+    for(i = 0; i < BLK_SIZE; i++) {
+        hexdump_char(block[i], hex_str);
         printf("%s", hex_str);
 
         /* make output readable in 4 byte chunks */
@@ -395,7 +416,7 @@ pad(struct sha_hash_s *hash)
         }
 
         /* the msg block is full, so process the block */
-        compute_hash(hash);
+        compress_blocks(hash, hash->msg_block, 1);
 
         /* reset the msg block  */
         reset_block(hash->msg_block, BLK_SIZE);
@@ -444,12 +465,66 @@ pad(struct sha_hash_s *hash)
     hash->msg_idx+=4;
 
     /* the last (and final) block is now full, so process the block */
-    compute_hash(hash);
+    compress_blocks(hash, hash->msg_block, 1);
 
 }		/* -----  end of static function pad  ----- */
 
 
 
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  add_length
+ *  Description:  Adds len bytes to the 64-bit length (in bits)
+ *                of the msg, carrying from the lo 4 bytes into
+ *                the hi 4 bytes when the lo 4 bytes overflow.
+ * ==============================================================
+ */
+static void
+add_length(struct sha_hash_s *hash, size_t len)
+{
+    uint64 bits = (uint64) len << 3;
+    uint32 lo   = hash->lo_length + (uint32) bits;
+
+    /* the lo 4 bytes wrapped around, so carry into the hi 4 bytes */
+    if (lo < hash->lo_length)
+        hash->hi_length++;
+
+    hash->lo_length  = lo;
+    hash->hi_length += (uint32) (bits >> 32);
+}		/* -----  end of static function add_length  ----- */
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  compress_blocks
+ *  Description:  Passes nblocks consecutive msg blocks to the
+ *                compression engine picked for this CPU (see
+ *                engine.c) and counts them for --stats.  In the
+ *                library build (SHA_IFUNC) the engine is resolved
+ *                once, at load time, and nothing is counted.
+ * ==============================================================
+ */
+static void
+compress_blocks(struct sha_hash_s *hash, const uint8 *blocks, size_t nblocks)
+{
+#ifdef SHA_IFUNC
+    /* libsha1: the kernel was bound when the library was loaded */
+    sha_compress_auto(hash, blocks, nblocks);
+#else
+    const struct engine_s *engine = engine_get();
+
+    engine->compress(hash, blocks, nblocks);
+
+    if (sha_stats_enabled) {
+        STATS_ADD(blocks, nblocks);
+        STATS_ADD(engine_bytes[engine->id], (uint64) nblocks * BLK_SIZE);
+    }
+#endif
+}		/* -----  end of static function compress_blocks  ----- */
+
+
+
 /* 
  * ===  FUNCTION  ===============================================
  *         Name:  init
@@ -476,6 +551,8 @@ init(struct sha_hash_s *hash)
     hash->h_sub[3] = 0x10325476;
     hash->h_sub[4] = 0xC3D2E1F0;
 
+    hash->collision = 0;
+
 }		/* -----  end of static function init  ----- */
 
 
@@ -489,62 +566,28 @@ init(struct sha_hash_s *hash)
  *                which will either be stdin or a previously
  *                opened file descriptor.
  *
- *                It populates the msg block and keeps track of
- *                the file size (in bits).  Once a msg block is
- *                full, the function passes the block (or more
- *                specifically, a pointer to the struct) off to
- *                the compute_hash function.
+ *                The input is read IO_BUF_SIZE bytes at a time by
+ *                sha_hash_update_fd( ) and each buffer is handed
+ *                to sha_hash_update( ), which populates the msg
+ *                block, keeps track of the file size (in bits)
+ *                and passes each full msg block off to the
+ *                compute_hash function.
  * ==============================================================
  */
 static void
 process_file(struct sha_hash_s *hash, FILE *fd)
 {
-
-    int ch = 0;
-
-    /* loop over file descriptor, fd, reading a single character
-     * at a time until we hit the end of file */
-    while( (ch = fgetc(fd)) != EOF  ) {
-
-        /* add character to the current msg block as long as there is room */
-        if (hash->msg_idx < BLK_SIZE) {
-            hash->msg_block[hash->msg_idx++] = ch;
-
-
-        /* msg block if full, so pass off the current block and start new one */
-        } else { 
-            compute_hash(hash);
-
-            /* reset the block */
-            reset_block(hash->msg_block, BLK_SIZE);
-            hash->msg_idx = 0;
-
-            /* can't lose the character we just grabbed on this pass */
-            hash->msg_block[hash->msg_idx++] = ch;
-        }
-
-        /* increment the length of the msg; if the lo 4 bytes are full
-         * that is == 2^32, then reset lo 4 bytes and increment the hi
-         * 4 bytes, otherwise just add the 8 bits to the length  */
-        if (hash->lo_length == 0xFFFFFFFF) {
-            hash->lo_length = 0;
-            hash->hi_length++;
-
-        } else {
-            hash->lo_length += 8;
-        }
+    /* nothing has been read through fd, so its stdio buffer is
+     * empty and the underlying descriptor can be read directly */
+    if (sha_hash_update_fd(hash, fileno(fd)) < 0) {
+        fprintf(stderr, "error reading input\n");
+        exit(EXIT_FAILURE);
     }
 
-    /* need to handle the end case when EOF is encountered at a
-     * multiple of 512 bits (or 64 bytes).  without this,
-     * compute_hash would never be called. */
-    if (hash->msg_idx == 64)
-        compute_hash(hash);
-
     /* always pad the msg */
     pad(hash);
 
-}		/* -----  end of static function rocess_file  ----- */
+}		/* -----  end of static function process_file  ----- */
 
 
 
@@ -555,54 +598,16 @@ process_file(struct sha_hash_s *hash, FILE *fd)
  *                corresponding members of the sha_hash_s struct.
  *                The input is specified by the string, str.
  *
- *                It populates the msg block and keeps track of
- *                the string size (in bits).  Once a msg block is
- *                full, the function passes the block (or more
- *                specifically, a pointer to the struct) off to
- *                the compute_hash function.
+ *                The string is handed to sha_hash_update( ),
+ *                which populates the msg block, keeps track of
+ *                the string size (in bits) and passes each full
+ *                msg block off to the compute_hash function.
  * ==============================================================
  */
 static void
 process_str(struct sha_hash_s *hash, char *str)
 {
-    while (*str) {
-
-        /* add character to the current msg block as long as there is room */
-        if (hash->msg_idx < BLK_SIZE) {
-            hash->msg_block[hash->msg_idx++] = *str;
-
-
-        /* msg block if full, so pass off the current block and start new one */
-        } else { 
-            compute_hash(hash);
-
-            /* reset the block */
-            reset_block(hash->msg_block, BLK_SIZE);
-            hash->msg_idx = 0;
-
-            /* can't lose the character we just grabbed on this pass */
-            hash->msg_block[hash->msg_idx++] = *str;
-        }
-
-        /* increment the length of the msg; if the lo 4 bytes are full
-         * that is == 2^32, then reset lo 4 bytes and increment the hi
-         * 4 bytes, otherwise just add the 8 bits to the length  */
-        if (hash->lo_length == 0xFFFFFFFF) {
-            hash->lo_length = 0;
-            hash->hi_length++;
-
-        } else {
-            hash->lo_length += 8;
-        }
-
-        str++;
-    }
-
-    /* need to handle the end case when EOF is encountered at a
-     * multiple of 512 bits (or 64 bytes).  without this,
-     * compute_hash would never be called. */
-    if (hash->msg_idx == 64)
-        compute_hash(hash);
+    sha_hash_update(hash, (const uint8 *) str, strlen(str));
 
     /* always pad the msg */
     pad(hash);
@@ -616,6 +621,7 @@ process_str(struct sha_hash_s *hash, char *str)
  *         Name:  compute_hash
  *  Description:  This is the heavy lifting function of the sha-1
  *                algorithm. Conducts 80 rounds of computations
+ *                over the 64 byte msg block pointed to by block
  *                and updates the msg digest arrary each time.
  *                When complete, the five 32-bit words that make
  *                up the msg digest array contain the
@@ -626,12 +632,12 @@ process_str(struct sha_hash_s *hash, char *str)
  * ==============================================================
  */
 static void
-compute_hash(struct sha_hash_s *hash)
+compute_hash(struct sha_hash_s *hash, const uint8 *block)
 {
 
 #ifdef DEBUG
     char hex_word[] = "00000000";
-    print_block(hash);
+    print_block(hash, block);
 #endif
 
     uint32 w[80] = { 0 };
@@ -657,7 +663,7 @@ compute_hash(struct sha_hash_s *hash)
     for(t = 0; t < 80; t++) {
         if (t < 16) {
 
-            w[t] = get_uint32(hash->msg_block, t*4);
+            w[t] = get_uint32((uint8 *) block, t*4);
 
         } else {
             w[t] = rotl((w[t-3] ^ w[t-8] ^ w[t-14] ^ w[t-16]), 1);
@@ -861,10 +867,294 @@ sha_hash_str(char *str)
 void
 sha_hash_file_output(char *filename)
 {
+    char  *digest = sha_hash_file(filename);
+    uint64 start  = STATS_CLOCK();
+
     if (filename == NULL) {
-        printf("%s  -\n", sha_hash_file(filename));
+        printf("%s  -\n", digest);
 
     } else {
-        printf("%s  %s\n", sha_hash_file(filename), filename);
+        printf("%s  %s\n", digest, filename);
     }
+
+    STATS_ADD(stage_ns[STAGE_OUTPUT], STATS_CLOCK() - start);
 }		/* -----  end of function sha_hash_file_output  ----- */
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_hash_init
+ *  Description:  API function to prepare a caller owned
+ *                sha_hash_s struct for sha_hash_update( ).
+ *                Together with sha_hash_update( ) and
+ *                sha_hash_final( ) this allows a msg to be
+ *                hashed a piece at a time, as it arrives, rather
+ *                than all at once from a file or a string.
+ * ==============================================================
+ */
+void
+sha_hash_init(struct sha_hash_s *hash)
+{
+    init(hash);
+}		/* -----  end of function sha_hash_init  ----- */
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_hash_update
+ *  Description:  API function to add len bytes, pointed to by
+ *                buf, to the msg being hashed.  Bytes are
+ *                gathered into the msg block until it is full;
+ *                once the msg block is empty, any full 64 byte
+ *                blocks remaining in buf are passed to the
+ *                compression engine at once, without being copied.
+ * ==============================================================
+ */
+void
+sha_hash_update(struct sha_hash_s *hash, const uint8 *buf, size_t len)
+{
+    uint64 start = STATS_CLOCK();
+    size_t n;
+
+    add_length(hash, len);
+
+    /* top off a partially filled msg block first */
+    if (hash->msg_idx > 0) {
+        n = BLK_SIZE - hash->msg_idx;
+        if (n > len)
+            n = len;
+
+        memcpy(hash->msg_block + hash->msg_idx, buf, n);
+        hash->msg_idx += n;
+        buf += n;
+        len -= n;
+
+        if (hash->msg_idx < BLK_SIZE)
+            return;
+
+        compress_blocks(hash, hash->msg_block, 1);
+        hash->msg_idx = 0;
+    }
+
+    /* full blocks are processed in place */
+    n = len / BLK_SIZE;
+    if (n > 0) {
+        compress_blocks(hash, buf, n);
+        buf += n * BLK_SIZE;
+        len -= n * BLK_SIZE;
+    }
+
+    /* save the tail for the next call (or for pad) */
+    memcpy(hash->msg_block, buf, len);
+    hash->msg_idx = len;
+
+    STATS_ADD(stage_ns[STAGE_COMPRESS], STATS_CLOCK() - start);
+
+}		/* -----  end of function sha_hash_update  ----- */
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_hash_update_x4
+ *  Description:  Adds len bytes from each of the ENGINE_LANES
+ *                buffers in bufs to the matching msg in hash.
+ *                Every hash must be freshly initialized (or have
+ *                only been given whole msg blocks so far).  When
+ *                the engine has a multi-lane kernel, the full
+ *                blocks of all lanes are compressed together;
+ *                otherwise each lane goes through
+ *                sha_hash_update( ) in turn.
+ * ==============================================================
+ */
+void
+sha_hash_update_x4(struct sha_hash_s **hash, const uint8 **bufs, size_t len)
+{
+    const struct engine_s *engine = engine_get();
+    const uint8 *tails[ENGINE_LANES];
+    uint64 start = STATS_CLOCK();
+    size_t nblocks = len / BLK_SIZE;
+    int i;
+
+    if (engine->compress_x4 == NULL || nblocks == 0) {
+        for (i = 0; i < ENGINE_LANES; i++)
+            sha_hash_update(hash[i], bufs[i], len);
+        return;
+    }
+
+    engine->compress_x4(hash, bufs, nblocks);
+
+    for (i = 0; i < ENGINE_LANES; i++) {
+        add_length(hash[i], nblocks * BLK_SIZE);
+        tails[i] = bufs[i] + nblocks * BLK_SIZE;
+    }
+
+    if (sha_stats_enabled) {
+        STATS_ADD(blocks, (uint64) nblocks * ENGINE_LANES);
+        STATS_ADD(engine_bytes[engine->id],
+                  (uint64) nblocks * ENGINE_LANES * BLK_SIZE);
+        STATS_ADD(stage_ns[STAGE_COMPRESS], stats_now() - start);
+    }
+
+    /* the partial last blocks go the ordinary way */
+    for (i = 0; i < ENGINE_LANES; i++)
+        sha_hash_update(hash[i], tails[i], len - nblocks * BLK_SIZE);
+
+}		/* -----  end of function sha_hash_update_x4  ----- */
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_compress_generic
+ *  Description:  The portable compression engine: passes each of
+ *                the nblocks msg blocks to compute_hash in turn.
+ *                This is the only engine used in DEBUG builds, so
+ *                the verbose output is always available.
+ * ==============================================================
+ */
+void
+sha_compress_generic(struct sha_hash_s *hash, const uint8 *blocks,
+                     size_t nblocks)
+{
+    while (nblocks-- > 0) {
+        compute_hash(hash, blocks);
+        blocks += BLK_SIZE;
+    }
+}		/* -----  end of function sha_compress_generic  ----- */
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_hash_update_fd
+ *  Description:  API function to add everything that can be read
+ *                from the file descriptor fd, up to end of file,
+ *                to the msg being hashed.  The input is read with
+ *                read(2) IO_BUF_SIZE bytes at a time, bypassing
+ *                stdio, and each buffer is passed to
+ *                sha_hash_update( ).  Reads go through
+ *                stats_read( ) so they show up in --stats.
+ *                A pipe is read by a pipeline_s reader thread in
+ *                large buffers instead, so reading the next buffer
+ *                overlaps hashing this one.
+ *
+ *                Returns the number of bytes read, or -1 on a
+ *                read error (with errno set).
+ * ==============================================================
+ */
+long long
+sha_hash_update_fd(struct sha_hash_s *hash, int fd)
+{
+    uint8 buf[IO_BUF_SIZE];
+
+    return sha_hash_update_fd_buf(hash, fd, buf, sizeof(buf));
+}		/* -----  end of function sha_hash_update_fd  ----- */
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_hash_update_fd_buf
+ *  Description:  API function like sha_hash_update_fd( ), reading
+ *                into the caller's buffer buf, of size bytes,
+ *                instead of one on the stack; for workers that
+ *                keep a large buffer in an arena_s.  Reads are at
+ *                most PIPELINE_BUF_SIZE bytes, so each one is
+ *                hashed while it is still in cache.  If size is at
+ *                least PIPELINE_SIZE, a pipe's pipeline_s uses buf
+ *                for its buffers rather than allocating them.
+ * ==============================================================
+ */
+long long
+sha_hash_update_fd_buf(struct sha_hash_s *hash, int fd, uint8 *buf,
+                       size_t size)
+{
+    long long total = 0;
+    ssize_t   n;
+
+    struct pipeline_s pl;
+    struct stat       st;
+    const uint8      *data;
+    uint8            *ring = size >= PIPELINE_SIZE ? buf : NULL;
+
+    if (size > PIPELINE_BUF_SIZE)
+        size = PIPELINE_BUF_SIZE;
+
+    /* overlap reading a pipe with hashing it */
+    if (fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode)
+            && pipeline_start(&pl, fd, ring) == 0) {
+
+        while ((n = pipeline_next(&pl, &data)) > 0) {
+            sha_hash_update(hash, data, n);
+            total += n;
+        }
+
+        pipeline_finish(&pl);
+
+        return n < 0 ? -1 : total;
+    }
+
+    while ((n = stats_read(fd, buf, size)) > 0) {
+        sha_hash_update(hash, buf, n);
+        total += n;
+    }
+
+    if (n < 0)
+        return -1;
+
+    return total;
+}		/* -----  end of function sha_hash_update_fd_buf  ----- */
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_hash_final
+ *  Description:  API function to pad the msg and copy the
+ *                resulting 160-bit msg digest, most significant
+ *                byte first, into digest, which must be at least
+ *                DIGEST_SIZE bytes in length.  The sha_hash_s
+ *                struct must be passed to sha_hash_init( )
+ *                before it is used again.
+ * ==============================================================
+ */
+void
+sha_hash_final(struct sha_hash_s *hash, uint8 *digest)
+{
+    int i;
+
+    pad(hash);
+
+    for(i = 0; i < 5; i++) {
+        digest[i*4 + 0] = get_uint8(hash->h_sub[i], 3);
+        digest[i*4 + 1] = get_uint8(hash->h_sub[i], 2);
+        digest[i*4 + 2] = get_uint8(hash->h_sub[i], 1);
+        digest[i*4 + 3] = get_uint8(hash->h_sub[i], 0);
+    }
+}		/* -----  end of function sha_hash_final  ----- */
+
+
+
+/* 
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_hash_hex
+ *  Description:  API function to convert a raw msg digest, as
+ *                filled in by sha_hash_final( ), into the null
+ *                terminated 40 char hex string printed by
+ *                sha_hash_file_output( ).  hex must be at least
+ *                HEX_SIZE bytes in length.
+ * ==============================================================
+ */
+void
+sha_hash_hex(const uint8 *digest, char *hex)
+{
+    int i;
+    for(i = 0; i < DIGEST_SIZE; i++) {
+        hexdump_char(digest[i], hex + (i*2));
+    }
+
+    hex[HEX_SIZE - 1] = '\0';
+}		/* -----  end of function sha_hash_hex  ----- */
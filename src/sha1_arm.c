@@ -0,0 +1,282 @@
+/*
+ * ==============================================================
+ *       Filename:  sha1_arm.c
+ *
+ *    Description:  ARM64 compression engines: one built on the
+ *                  ARMv8 SHA1 crypto extension instructions
+ *                  (sha1c/sha1p/sha1m, sha1h, sha1su0/sha1su1) and
+ *                  a NEON kernel that hashes four independent msgs
+ *                  at once, one per 32-bit vector lane.  Both are
+ *                  only used after getauxval(AT_HWCAP) says the CPU
+ *                  has the instructions.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#include "engine.h"
+
+#if defined(__aarch64__)
+
+#include <sys/auxv.h>
+#include <arm_neon.h>
+
+
+#ifndef HWCAP_ASIMD
+#define HWCAP_ASIMD  (1 << 1)
+#endif
+
+#ifndef HWCAP_SHA1
+#define HWCAP_SHA1   (1 << 5)
+#endif
+
+/* rotl for all four lanes; n must be a constant */
+#define ROTL_X4(x, n)  vorrq_u32(vshlq_n_u32((x), (n)), vshrq_n_u32((x), 32 - (n)))
+
+
+/* Constants K sub t */
+static const uint32 k[ ] = { 0x5A827999,      /* K for  0 <= t <= 19 */
+                             0x6ED9EBA1,      /* K for 20 <= t <= 39 */
+                             0x8F1BBCDC,      /* K for 40 <= t <= 59 */
+                             0xCA62C1D6       /* K for 60 <= t <= 79 */
+};
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_arm_ce_available
+ *  Description:  Returns non-zero if the CPU has the ARMv8 SHA1
+ *                instructions.
+ * ==============================================================
+ */
+int
+sha_arm_ce_available(void)
+{
+    return (getauxval(AT_HWCAP) & HWCAP_SHA1) != 0;
+}		/* -----  end of function sha_arm_ce_available  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_neon_available
+ *  Description:  Returns non-zero if the CPU has Advanced SIMD
+ *                (NEON), which every ARMv8-A CPU running Linux
+ *                should.
+ * ==============================================================
+ */
+int
+sha_neon_available(void)
+{
+    return (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+}		/* -----  end of function sha_neon_available  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_compress_arm_ce
+ *  Description:  Compresses nblocks msg blocks with the crypto
+ *                extension.  Each sha1c/sha1p/sha1m does four
+ *                rounds on A..D held in one vector; sha1h gives
+ *                the E for the next four rounds, and
+ *                sha1su0/sha1su1 expand the msg schedule four
+ *                words at a time:
+ *
+ *                  W[i..i+3] = su1(su0(W[i-16..], W[i-12..],
+ *                                      W[i-8..]), W[i-4..])
+ * ==============================================================
+ */
+void
+sha_compress_arm_ce(struct sha_hash_s *hash, const uint8 *blocks,
+                    size_t nblocks)
+{
+    uint32x4_t abcd = vld1q_u32(hash->h_sub);
+    uint32     e    = hash->h_sub[4];
+
+    uint32x4_t abcd_saved, wk, w[4];
+    uint32     e_saved, e_next;
+    int i;
+
+    while (nblocks-- > 0) {
+        abcd_saved = abcd;
+        e_saved    = e;
+
+        /* the msg block is big-endian */
+        for (i = 0; i < 4; i++)
+            w[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + i*16)));
+
+        /* 20 groups of 4 rounds; w[] holds the last 16 schedule words */
+        for (i = 0; i < 20; i++) {
+            if (i >= 4)
+                w[i & 3] = vsha1su1q_u32(vsha1su0q_u32(w[i & 3],
+                                                       w[(i + 1) & 3],
+                                                       w[(i + 2) & 3]),
+                                         w[(i + 3) & 3]);
+
+            wk     = vaddq_u32(w[i & 3], vdupq_n_u32(k[i / 5]));
+            e_next = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+
+            if (i < 5)
+                abcd = vsha1cq_u32(abcd, e, wk);        /* ch */
+            else if (i >= 10 && i < 15)
+                abcd = vsha1mq_u32(abcd, e, wk);        /* maj */
+            else
+                abcd = vsha1pq_u32(abcd, e, wk);        /* parity */
+
+            e = e_next;
+        }
+
+        abcd = vaddq_u32(abcd, abcd_saved);
+        e   += e_saved;
+
+        blocks += BLK_SIZE;
+    }
+
+    vst1q_u32(hash->h_sub, abcd);
+    hash->h_sub[4] = e;
+
+}		/* -----  end of function sha_compress_arm_ce  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  load_lanes
+ *  Description:  Builds a vector from the big-endian word at
+ *                offset off of each lane's msg block.
+ * ==============================================================
+ */
+static uint32x4_t
+load_lanes(const uint8 **blocks, size_t off)
+{
+    uint32 word[ENGINE_LANES];
+    const uint8 *p;
+    int i;
+
+    for (i = 0; i < ENGINE_LANES; i++) {
+        p = blocks[i] + off;
+        word[i] = ((uint32) p[0] << 24) | ((uint32) p[1] << 16)
+                | ((uint32) p[2] <<  8) |  (uint32) p[3];
+    }
+
+    return vld1q_u32(word);
+}		/* -----  end of static function load_lanes  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_compress_neon_x4
+ *  Description:  Compresses nblocks msg blocks of four
+ *                independent msgs at once.  This is compute_hash
+ *                with every 32-bit variable widened to a vector
+ *                whose lane i belongs to hash[i]; the lanes never
+ *                interact, so the rounds need no crypto
+ *                instructions, only NEON adds, logic ops and
+ *                shifts.
+ * ==============================================================
+ */
+void
+sha_compress_neon_x4(struct sha_hash_s **hash, const uint8 **blocks,
+                     size_t nblocks)
+{
+    uint32x4_t h[5], saved[5], w[16];
+    uint32x4_t a, b, c, d, e, f, kt, temp;
+    uint32     word[ENGINE_LANES];
+    size_t     off;
+    int i, t;
+
+    /* transpose the states: h[i] lane j is hash[j]->h_sub[i] */
+    for (i = 0; i < 5; i++) {
+        for (t = 0; t < ENGINE_LANES; t++)
+            word[t] = hash[t]->h_sub[i];
+        h[i] = vld1q_u32(word);
+    }
+
+    for (off = 0; off < nblocks * BLK_SIZE; off += BLK_SIZE) {
+        for (i = 0; i < 5; i++)
+            saved[i] = h[i];
+
+        a = h[0];
+        b = h[1];
+        c = h[2];
+        d = h[3];
+        e = h[4];
+
+        for (t = 0; t < 80; t++) {
+            if (t < 16)
+                w[t] = load_lanes(blocks, off + t*4);
+            else
+                w[t & 15] = ROTL_X4(veorq_u32(veorq_u32(w[(t - 3) & 15],
+                                                        w[(t - 8) & 15]),
+                                              veorq_u32(w[(t - 14) & 15],
+                                                        w[t & 15])), 1);
+
+            if (t < 20) {
+                f  = vbslq_u32(b, c, d);                            /* ch */
+                kt = vdupq_n_u32(k[0]);
+            } else if (t < 40) {
+                f  = veorq_u32(veorq_u32(b, c), d);                 /* parity */
+                kt = vdupq_n_u32(k[1]);
+            } else if (t < 60) {
+                f  = vorrq_u32(vandq_u32(b, c),
+                               vandq_u32(d, vorrq_u32(b, c)));      /* maj */
+                kt = vdupq_n_u32(k[2]);
+            } else {
+                f  = veorq_u32(veorq_u32(b, c), d);                 /* parity */
+                kt = vdupq_n_u32(k[3]);
+            }
+
+            temp = vaddq_u32(vaddq_u32(ROTL_X4(a, 5), f),
+                             vaddq_u32(vaddq_u32(e, w[t & 15]), kt));
+
+            e = d;
+            d = c;
+            c = ROTL_X4(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        h[0] = vaddq_u32(saved[0], a);
+        h[1] = vaddq_u32(saved[1], b);
+        h[2] = vaddq_u32(saved[2], c);
+        h[3] = vaddq_u32(saved[3], d);
+        h[4] = vaddq_u32(saved[4], e);
+    }
+
+    for (i = 0; i < 5; i++) {
+        vst1q_u32(word, h[i]);
+        for (t = 0; t < ENGINE_LANES; t++)
+            hash[t]->h_sub[i] = word[t];
+    }
+
+}		/* -----  end of function sha_compress_neon_x4  ----- */
+
+#else
+
+/* nothing to build on this target; ISO C doesn't allow an empty
+ * translation unit */
+typedef int sha1_arm_unused;
+
+#endif
@@ -0,0 +1,727 @@
+/*
+ * ==============================================================
+ *       Filename:  sha1dc.c
+ *
+ *    Description:  Collision attack detection, after SHA-1DC
+ *                  (M. Stevens, D. Shumow, "Speeding up detection
+ *                  of SHA-1 collision attacks using unavoidable
+ *                  attack conditions", USENIX Security '17).
+ *
+ *                  Every known practical SHA-1 collision attack
+ *                  uses one of a few disturbance vectors (DVs),
+ *                  and the last near-collision block of an attack
+ *                  shares its internal state at some step with a
+ *                  partner block that differs from it by the
+ *                  message difference of that DV.  For each DV,
+ *                  the partner is recomputed from the stored
+ *                  state; if it ends in the same chaining value,
+ *                  the block completes a collision.  Cheap message
+ *                  bit conditions that every attack with the DV
+ *                  must satisfy rule out almost all blocks before
+ *                  that recompression is needed.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <pthread.h>
+#include "engine.h"
+#include "stats.h"
+
+
+#define DC_NUM_DVS     32
+#define DC_MAX_CONDS   12     /* conditions checked per DV */
+#define DC_MAX_CANDS   512    /* distinct conditions of all the DVs */
+
+/* conditions are only taken from steps where every attack follows
+ * its DV bit for bit: after the non-linear first round, and before
+ * the last steps, whose differences attacks may shape freely */
+#define DC_COND_FIRST  24
+#define DC_COND_LAST   75
+
+/* the steps whose states are kept for recompression */
+#define DC_TEST_EARLY  58
+#define DC_TEST_LATE   65
+
+/* the conditions checked for every block, as t1, b1, t2, b2, differ
+ * (see struct dc_cond_s).  Spelled out, so that the shared pass is
+ * unrolled with constant shifts.  They were picked greedily from the
+ * conditions init_dv( ) derives, each time taking the one needed by
+ * the most DVs with fewer than 6 so far, so every DV has at least 6
+ * of its conditions here; which DVs need each is still derived, in
+ * init_dvs( ) */
+#define DC_SHARED(X) \
+    X(73,  3, 74,  8, 1) \
+    X(74,  3, 75,  8, 1) \
+    X(72,  3, 73,  8, 1) \
+    X(69,  3, 70,  8, 1) \
+    X(68,  1, 69,  6, 1) \
+    X(69,  1, 70,  6, 1) \
+    X(24,  1, 25,  6, 1) \
+    X(70,  1, 71,  6, 1) \
+    X(25,  1, 26,  6, 1) \
+    X(26, 30, 27,  3, 1) \
+    X(26, 30, 31, 28, 1) \
+    X(27, 30, 28,  3, 1) \
+    X(27, 30, 32, 28, 1) \
+    X(65,  2, 66,  7, 1) \
+    X(65,  2, 70,  0, 1) \
+    X(67,  1, 68,  6, 1) \
+    X(66,  2, 67,  7, 1) \
+    X(25,  4, 29, 29, 0) \
+    X(32,  1, 33,  6, 1) \
+    X(26,  4, 30, 29, 0) \
+    X(71,  3, 72,  8, 1) \
+    X(27,  4, 31, 29, 0) \
+    X(71,  1, 72,  6, 1) \
+    X(72,  1, 73,  6, 1) \
+    X(73,  1, 74,  6, 1) \
+    X(74,  1, 75,  6, 1) \
+    X(30,  4, 34, 29, 0) \
+    X(64,  2, 65,  7, 1) \
+    X(64,  2, 69,  0, 1) \
+    X(24, 30, 25,  3, 1) \
+    X(24, 30, 29, 28, 1) \
+    X(25, 30, 26,  3, 1) \
+    X(25, 30, 30, 28, 1) \
+    X(70,  3, 71,  8, 1) \
+    X(28,  1, 29,  6, 1) \
+    X(29,  1, 30,  6, 1) \
+    X(68,  2, 69,  7, 1) \
+    X(39,  4, 43, 29, 0) \
+    X(42,  4, 46, 29, 0) \
+    X(66,  1, 67,  6, 1) \
+    X(61,  0, 62,  5, 1) \
+    X(35,  1, 36,  6, 1) \
+    X(30,  1, 31,  6, 1) \
+    X(36,  1, 37,  6, 1) \
+    X(26,  1, 27,  6, 1) \
+    X(41,  1, 42,  6, 1) \
+    X(66,  0, 67,  5, 1) \
+    X(67,  0, 68,  5, 1) \
+    X(43,  4, 47, 29, 0) \
+    X(45,  4, 49, 29, 0) \
+    X(46,  4, 50, 29, 0) \
+    X(71,  0, 72,  5, 1) \
+    X(31,  4, 35, 29, 0) \
+    X(68,  3, 69,  8, 1) \
+    X(32,  4, 36, 29, 0) \
+    X(27,  0, 28,  5, 1) \
+    X(28,  4, 32, 29, 0) \
+    X(29,  4, 33, 29, 0) \
+    X(44,  4, 48, 29, 0) \
+    X(68,  0, 69,  5, 1)
+
+#define DC_NUM_SHARED  60
+
+#define DC_COND_INIT(t1, b1, t2, b2, differ)  { t1, b1, t2, b2, differ, 0 },
+
+
+/* message bit condition: bit b1 of W[t1] must differ from (or equal,
+ * if differ is 0) bit b2 of W[t2].  dvs has a bit set for every DV
+ * that needs it */
+struct dc_cond_s {
+
+    uint8   t1, b1;
+    uint8   t2, b2;
+    uint8   differ;
+    uint32  dvs;
+
+};
+
+struct dc_dv_s {
+
+    int     type;                 /* I or II (1 or 2) */
+    int     k;                    /* DV I(K,b) or II(K,b) */
+    int     b;
+    int     testt;                /* the step with no state difference */
+
+    uint32  dm[80];               /* message difference */
+
+    int     nshared;              /* of its conditions in shared[ ] */
+    int     ncond;                /* the rest, checked one by one */
+    struct dc_cond_s cond[DC_MAX_CONDS];
+
+};
+
+
+/******************** GLOBAL VARIABLES *************************/
+
+/* the DVs checked by SHA-1DC: type, K, b */
+static const int dv_params[DC_NUM_DVS][3] = {
+    { 1, 43, 0 }, { 1, 44, 0 }, { 1, 45, 0 }, { 1, 46, 0 },
+    { 1, 46, 2 }, { 1, 47, 0 }, { 1, 47, 2 }, { 1, 48, 0 },
+    { 1, 48, 2 }, { 1, 49, 0 }, { 1, 49, 2 }, { 1, 50, 0 },
+    { 1, 50, 2 }, { 1, 51, 0 }, { 1, 51, 2 }, { 1, 52, 0 },
+    { 2, 45, 0 }, { 2, 46, 0 }, { 2, 46, 2 }, { 2, 47, 0 },
+    { 2, 48, 0 }, { 2, 49, 0 }, { 2, 49, 2 }, { 2, 50, 0 },
+    { 2, 50, 2 }, { 2, 51, 0 }, { 2, 51, 2 }, { 2, 52, 0 },
+    { 2, 53, 0 }, { 2, 54, 0 }, { 2, 55, 0 }, { 2, 56, 0 }
+};
+
+/* filled in from dv_params on first use */
+static struct dc_dv_s  dvs[DC_NUM_DVS];
+static pthread_once_t  dvs_once = PTHREAD_ONCE_INIT;
+
+/* every condition derived, then those checked for all blocks; the
+ * dvs of shared[n] are in shared_dvs[n] */
+static struct dc_cond_s cands[DC_MAX_CANDS];
+static int              ncands = 0;
+static const struct dc_cond_s shared[DC_NUM_SHARED] = {
+    DC_SHARED(DC_COND_INIT)
+};
+static uint32           shared_dvs[DC_NUM_SHARED];
+
+/* attack blocks found so far, by every thread */
+static uint64 detected = 0;
+
+/* Constants K sub t */
+static const uint32 k[ ] = { 0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6 };
+
+/**************************************************************/
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  rotl, rotr
+ *  Description:  Rotate word left or right by n bits, 0 < n < 32.
+ * ==============================================================
+ */
+static uint32
+rotl(uint32 word, int n)
+{
+    return (word << n) | (word >> (32 - n));
+}		/* -----  end of static function rotl  ----- */
+
+static uint32
+rotr(uint32 word, int n)
+{
+    return (word >> n) | (word << (32 - n));
+}		/* -----  end of static function rotr  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  round_f
+ *  Description:  The logical function of step t, plus K sub t.
+ * ==============================================================
+ */
+static uint32
+round_f(int t, uint32 b, uint32 c, uint32 d)
+{
+    if (t < 20)
+        return ((b & c) | (~b & d)) + k[0];
+    if (t < 40)
+        return (b ^ c ^ d) + k[1];
+    if (t < 60)
+        return ((b & c) | (b & d) | (c & d)) + k[2];
+
+    return (b ^ c ^ d) + k[3];
+}		/* -----  end of static function round_f  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  dv_terms
+ *  Description:  Stores in terms the six contributions to the
+ *                message difference of step s: the disturbance
+ *                DV[s] itself and the corrections of the local
+ *                collisions started at steps s-1 ... s-5.  dv is
+ *                indexed from step -5.
+ * ==============================================================
+ */
+static void
+dv_terms(const uint32 *dv, int s, uint32 *terms)
+{
+    terms[0] = dv[s + 5];
+    terms[1] = rotl(dv[s + 4], 5);
+    terms[2] = dv[s + 3];
+    terms[3] = rotl(dv[s + 2], 30);
+    terms[4] = rotl(dv[s + 1], 30);
+    terms[5] = rotl(dv[s],     30);
+}		/* -----  end of static function dv_terms  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  only_from
+ *  Description:  Returns non-zero if bit of the message difference
+ *                of step s comes from term which of dv_terms( )
+ *                and from no other, so nothing else in step s can
+ *                change the sign the attack needs there.
+ * ==============================================================
+ */
+static int
+only_from(const uint32 *dv, int s, int bit, int which)
+{
+    uint32 terms[6];
+    int i;
+
+    if (s > DC_COND_LAST)
+        return 0;
+
+    dv_terms(dv, s, terms);
+
+    for (i = 0; i < 6; i++) {
+        if (((terms[i] >> bit) & 1) != (i == which))
+            return 0;
+    }
+
+    return 1;
+}		/* -----  end of static function only_from  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  add_cand
+ *  Description:  Records that DV number i needs a condition,
+ *                merging it with the same condition of other DVs.
+ * ==============================================================
+ */
+static void
+add_cand(int i, int t1, int b1, int t2, int b2, int differ)
+{
+    struct dc_cond_s *c;
+    int n;
+
+    for (n = 0; n < ncands; n++) {
+        c = &cands[n];
+        if (c->t1 == t1 && c->b1 == b1 && c->t2 == t2 && c->b2 == b2
+                && c->differ == differ) {
+            c->dvs |= (uint32) 1 << i;
+            return;
+        }
+    }
+
+    if (ncands == DC_MAX_CANDS)
+        return;
+
+    c = &cands[ncands++];
+    c->t1 = t1;
+    c->b1 = b1;
+    c->t2 = t2;
+    c->b2 = b2;
+    c->differ = differ;
+    c->dvs = (uint32) 1 << i;
+}		/* -----  end of static function add_cand  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  init_dv
+ *  Description:  Expands DV I(K,b) or II(K,b), the i-th DV, and
+ *                derives its message difference and bit
+ *                conditions.
+ *
+ *                A DV is a sequence that obeys the message
+ *                expansion.  Type I has DV[K..K+15] zero except
+ *                DV[K+15] = 2^b; type II also has DV[K+1] and
+ *                DV[K+3] = 2^(b-1); the rest follows from the
+ *                recurrence, forwards and backwards.
+ *
+ *                A disturbance at bit j of step t changes A by
+ *                +-2^j, which step t+1 cancels through bit j+5 of
+ *                W[t+1] and step t+5 through bit j+30 of W[t+5].
+ *                Cancelling needs opposite signs, and the sign of
+ *                a flip is set by the value of the flipped bit,
+ *                so W[t][j] != W[t+1][j+5] and W[t][j] !=
+ *                W[t+5][j+30].  At bit 31 signs don't matter; a
+ *                disturbance there only needs its two corrections
+ *                to agree, W[t+1][4] == W[t+5][29].
+ * ==============================================================
+ */
+static void
+init_dv(int i, int type, int k_, int b)
+{
+    struct dc_dv_s *dv = &dvs[i];
+    uint32 w[85];                       /* DV[-5 .. 79] */
+    uint32 terms[6];
+    int t, j, n;
+
+    dv->type  = type;
+    dv->k     = k_;
+    dv->b     = b;
+    dv->testt = k_ < 50 ? DC_TEST_EARLY : DC_TEST_LATE;
+    dv->nshared = 0;
+    dv->ncond   = 0;
+
+    memset(w, 0, sizeof(w));
+    w[k_ + 15 + 5] = (uint32) 1 << b;
+    if (type == 2)
+        w[k_ + 1 + 5] = w[k_ + 3 + 5] = rotl((uint32) 1 << b, 31);
+
+    for (t = k_ + 16; t < 80; t++)
+        w[t + 5] = rotl(w[t - 3 + 5] ^ w[t - 8 + 5] ^ w[t - 14 + 5]
+                        ^ w[t - 16 + 5], 1);
+
+    for (t = k_ - 1; t >= -5; t--)
+        w[t + 5] = rotr(w[t + 16 + 5], 1) ^ w[t + 13 + 5] ^ w[t + 8 + 5]
+                   ^ w[t + 2 + 5];
+
+    for (t = 0; t < 80; t++) {
+        dv_terms(w, t, terms);
+        dv->dm[t] = 0;
+        for (n = 0; n < 6; n++)
+            dv->dm[t] ^= terms[n];
+    }
+
+    for (t = DC_COND_FIRST; t < 80; t++) {
+        for (j = 0; j < 32; j++) {
+            if (!only_from(w, t, j, 0))
+                continue;
+
+            if (j != 31 && j != 26 && only_from(w, t + 1, (j + 5) % 32, 1))
+                add_cand(i, t, j, t + 1, (j + 5) % 32, 1);
+
+            if (j != 31 && j != 1 && only_from(w, t + 5, (j + 30) % 32, 5))
+                add_cand(i, t, j, t + 5, (j + 30) % 32, 1);
+
+            if (j == 31 && only_from(w, t + 1, 4, 1)
+                        && only_from(w, t + 5, 29, 5))
+                add_cand(i, t + 1, 4, t + 5, 29, 0);
+        }
+    }
+}		/* -----  end of static function init_dv  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  init_dvs
+ *  Description:  Fills in the DV table; run once.  Conditions are
+ *                split in two: the shared set of DC_SHARED, checked
+ *                for every block without branches, and the rest,
+ *                checked per DV only for the few DVs that pass the
+ *                shared set.  Each DV gets its remaining
+ *                conditions, up to DC_MAX_CONDS in all.
+ * ==============================================================
+ */
+static void
+init_dvs(void)
+{
+    const struct dc_cond_s *s;
+    struct dc_cond_s *c;
+    int i, n, m;
+
+    for (i = 0; i < DC_NUM_DVS; i++)
+        init_dv(i, dv_params[i][0], dv_params[i][1], dv_params[i][2]);
+
+    for (n = 0; n < ncands; n++) {
+        c = &cands[n];
+
+        for (m = 0; m < DC_NUM_SHARED; m++) {
+            s = &shared[m];
+            if (c->t1 == s->t1 && c->b1 == s->b1 && c->t2 == s->t2
+                    && c->b2 == s->b2 && c->differ == s->differ) {
+                shared_dvs[m] = c->dvs;
+
+                /* taken: don't give it out below */
+                c->dvs = 0;
+            }
+        }
+    }
+
+    for (m = 0; m < DC_NUM_SHARED; m++) {
+        for (i = 0; i < DC_NUM_DVS; i++) {
+            if (shared_dvs[m] >> i & 1)
+                dvs[i].nshared++;
+        }
+    }
+
+    for (n = 0; n < ncands; n++) {
+        c = &cands[n];
+
+        for (i = 0; i < DC_NUM_DVS; i++) {
+            if ((c->dvs >> i & 1)
+                    && dvs[i].nshared + dvs[i].ncond < DC_MAX_CONDS)
+                dvs[i].cond[dvs[i].ncond++] = *c;
+        }
+    }
+}		/* -----  end of static function init_dvs  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  recompress
+ *  Description:  Recomputes the partner block of the DV dv: runs
+ *                the steps before dv->testt backwards from the
+ *                state kept there, with the partner's message
+ *                w ^ dv->dm, to find its input chaining value,
+ *                then the remaining steps forwards.  Returns
+ *                non-zero if it ends in the chaining value ihv,
+ *                i.e. the two blocks collide.
+ * ==============================================================
+ */
+static int
+recompress(const struct dc_dv_s *dv, const uint32 *w, const uint32 *state,
+           const uint32 *ihv)
+{
+    uint32 w2[80], ihv2[5];
+    uint32 a, b, c, d, e, temp;
+    int t;
+
+    for (t = 0; t < 80; t++)
+        w2[t] = w[t] ^ dv->dm[t];
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+
+    for (t = dv->testt - 1; t >= 0; t--) {
+        temp = a;
+        a = b;
+        b = rotr(c, 30);
+        c = d;
+        d = e;
+        e = temp - rotl(a, 5) - round_f(t, b, c, d) - w2[t];
+    }
+
+    ihv2[0] = a;
+    ihv2[1] = b;
+    ihv2[2] = c;
+    ihv2[3] = d;
+    ihv2[4] = e;
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+
+    for (t = dv->testt; t < 80; t++) {
+        temp = rotl(a, 5) + round_f(t, b, c, d) + e + w2[t];
+        e = d;
+        d = c;
+        c = rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    return ihv2[0] + a == ihv[0] && ihv2[1] + b == ihv[1]
+        && ihv2[2] + c == ihv[2] && ihv2[3] + d == ihv[3]
+        && ihv2[4] + e == ihv[4];
+}		/* -----  end of static function recompress  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  compress_w
+ *  Description:  Compresses the expanded msg block w into ihv, the
+ *                plain SHA-1 way.
+ * ==============================================================
+ */
+static void
+compress_w(uint32 *ihv, const uint32 *w)
+{
+    uint32 a, b, c, d, e, temp;
+    int t;
+
+    a = ihv[0];
+    b = ihv[1];
+    c = ihv[2];
+    d = ihv[3];
+    e = ihv[4];
+
+    for (t = 0; t < 80; t++) {
+        temp = rotl(a, 5) + round_f(t, b, c, d) + e + w[t];
+        e = d;
+        d = c;
+        c = rotl(b, 30);
+        b = a;
+        a = temp;
+    }
+
+    ihv[0] += a;
+    ihv[1] += b;
+    ihv[2] += c;
+    ihv[3] += d;
+    ihv[4] += e;
+}		/* -----  end of static function compress_w  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  compress_block
+ *  Description:  Compresses one msg block into ihv, keeping the
+ *                expanded message and the states before steps
+ *                DC_TEST_EARLY and DC_TEST_LATE, then checks the
+ *                block against every DV.  Each condition holds for
+ *                half of all blocks, so after the shared pass a
+ *                DV survives for about 1 block in 2^6, and the
+ *                block is only recompressed for it if all of its
+ *                conditions hold, about 1 in 2^12.  Returns
+ *                non-zero if the block completes a collision; ihv
+ *                then holds the SHA-1DC "safe hash": the block is
+ *                compressed twice more, so that the two colliding
+ *                files no longer get the same digest.
+ * ==============================================================
+ */
+static int
+compress_block(uint32 *ihv, const uint8 *block)
+{
+    const struct dc_cond_s *c;
+
+    uint32 w[80], states[2][5];
+    uint32 a, b, cc, d, e, temp;
+    uint32 mask = ~(uint32) 0;
+    int t, i, n;
+
+    for (t = 0; t < 16; t++)
+        w[t] = ((uint32) block[t*4] << 24) | ((uint32) block[t*4 + 1] << 16)
+             | ((uint32) block[t*4 + 2] << 8) | (uint32) block[t*4 + 3];
+
+    for (t = 16; t < 80; t++)
+        w[t] = rotl(w[t-3] ^ w[t-8] ^ w[t-14] ^ w[t-16], 1);
+
+    a  = ihv[0];
+    b  = ihv[1];
+    cc = ihv[2];
+    d  = ihv[3];
+    e  = ihv[4];
+
+#define DC_STEP(f, kt)                                                  \
+    do {                                                                \
+        temp = rotl(a, 5) + (f) + e + (kt) + w[t];                      \
+        e  = d;                                                         \
+        d  = cc;                                                        \
+        cc = rotl(b, 30);                                               \
+        b  = a;                                                         \
+        a  = temp;                                                      \
+    } while (0)
+
+#define DC_SAVE(s)                                                      \
+    do {                                                                \
+        (s)[0] = a; (s)[1] = b; (s)[2] = cc; (s)[3] = d; (s)[4] = e;    \
+    } while (0)
+
+    for (t = 0; t < 20; t++)
+        DC_STEP((b & cc) | (~b & d), k[0]);
+    for (; t < 40; t++)
+        DC_STEP(b ^ cc ^ d, k[1]);
+    for (; t < DC_TEST_EARLY; t++)
+        DC_STEP((b & cc) | (b & d) | (cc & d), k[2]);
+    DC_SAVE(states[0]);
+    for (; t < 60; t++)
+        DC_STEP((b & cc) | (b & d) | (cc & d), k[2]);
+    for (; t < DC_TEST_LATE; t++)
+        DC_STEP(b ^ cc ^ d, k[3]);
+    DC_SAVE(states[1]);
+    for (; t < 80; t++)
+        DC_STEP(b ^ cc ^ d, k[3]);
+
+#undef DC_STEP
+#undef DC_SAVE
+
+    ihv[0] += a;
+    ihv[1] += b;
+    ihv[2] += cc;
+    ihv[3] += d;
+    ihv[4] += e;
+
+    /* drop every DV one of whose shared conditions fails; no
+     * branches, so nothing to mispredict on random data */
+#define DC_CHECK(t1, b1, t2, b2, differ)                                \
+    temp  = ((w[t1] >> (b1)) ^ (w[t2] >> (b2)) ^ !(differ)) & 1;        \
+    mask &= (0 - temp) | ~shared_dvs[n++];
+
+    n = 0;
+    DC_SHARED(DC_CHECK)
+
+#undef DC_CHECK
+
+    for (i = 0; mask != 0; i++, mask >>= 1) {
+        if ((mask & 1) == 0)
+            continue;
+
+        for (n = 0; n < dvs[i].ncond; n++) {
+            c = &dvs[i].cond[n];
+            if ((((w[c->t1] >> c->b1) ^ (w[c->t2] >> c->b2)) & 1) != c->differ)
+                break;
+        }
+
+        if (n == dvs[i].ncond
+                && recompress(&dvs[i], w, states[dvs[i].testt == DC_TEST_LATE],
+                              ihv)) {
+            compress_w(ihv, w);
+            compress_w(ihv, w);
+            return 1;
+        }
+    }
+
+    return 0;
+}		/* -----  end of static function compress_block  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_compress_dc
+ *  Description:  The sha1dc engine: compresses nblocks msg blocks
+ *                like sha_compress_generic( ), setting
+ *                hash->collision if any of them completes a
+ *                collision attack.  Such blocks are compressed
+ *                three times in all, so the digest is the one
+ *                sha1dc prints rather than the colliding one.
+ * ==============================================================
+ */
+void
+sha_compress_dc(struct sha_hash_s *hash, const uint8 *blocks, size_t nblocks)
+{
+    pthread_once(&dvs_once, init_dvs);
+
+    while (nblocks-- > 0) {
+        if (compress_block(hash->h_sub, blocks)) {
+            hash->collision = 1;
+            __atomic_fetch_add(&detected, 1, __ATOMIC_RELAXED);
+        }
+        blocks += BLK_SIZE;
+    }
+}		/* -----  end of function sha_compress_dc  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha_dc_detected
+ *  Description:  Returns the number of attack blocks found by the
+ *                sha1dc engine so far, in all threads.
+ * ==============================================================
+ */
+uint64
+sha_dc_detected(void)
+{
+    return __atomic_load_n(&detected, __ATOMIC_RELAXED);
+}		/* -----  end of function sha_dc_detected  ----- */
@@ -0,0 +1,254 @@
+/*
+ * ==============================================================
+ *       Filename:  sha256.c
+ *
+ *    Description:  SHA-256, as specified in FIPS 180-4, with the
+ *                  same incremental init/update/final interface as
+ *                  the SHA-1 implementation.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#include <string.h>
+#include "sha256.h"
+#include "stats.h"
+
+
+/******************** GLOBAL VARIABLES *************************/
+
+/* Constants K sub t: the first 32 bits of the fractional parts of
+ * the cube roots of the first 64 primes */
+static const uint32 k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* Initial hash value: the first 32 bits of the fractional parts
+ * of the square roots of the first 8 primes */
+static const uint32 h_init[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/**************************************************************/
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  rotr
+ *  Description:  Rotates word right by n bits, 0 < n < 32.
+ * ==============================================================
+ */
+static uint32
+rotr(uint32 word, int n)
+{
+    return (word >> n) | (word << (32 - n));
+}		/* -----  end of static function rotr  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  compute_hash
+ *  Description:  Conducts the 64 rounds of SHA-256 over the 64
+ *                byte msg block pointed to by block, adding the
+ *                result into the intermediate hash value.
+ * ==============================================================
+ */
+static void
+compute_hash(struct sha256_s *hash, const uint8 *block)
+{
+    uint32 w[64];
+    uint32 a, b, c, d, e, f, g, h, t1, t2;
+    int t;
+
+    for (t = 0; t < 64; t++) {
+        if (t < 16) {
+            w[t] = ((uint32) block[t*4]     << 24)
+                 | ((uint32) block[t*4 + 1] << 16)
+                 | ((uint32) block[t*4 + 2] <<  8)
+                 |  (uint32) block[t*4 + 3];
+        } else {
+            w[t] = (rotr(w[t-2], 17) ^ rotr(w[t-2], 19) ^ (w[t-2] >> 10))
+                 + w[t-7]
+                 + (rotr(w[t-15], 7) ^ rotr(w[t-15], 18) ^ (w[t-15] >> 3))
+                 + w[t-16];
+        }
+    }
+
+    a = hash->h_sub[0];
+    b = hash->h_sub[1];
+    c = hash->h_sub[2];
+    d = hash->h_sub[3];
+    e = hash->h_sub[4];
+    f = hash->h_sub[5];
+    g = hash->h_sub[6];
+    h = hash->h_sub[7];
+
+    for (t = 0; t < 64; t++) {
+        t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25))
+               + ((e & f) ^ (~e & g)) + k[t] + w[t];
+        t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22))
+               + ((a & b) ^ (a & c) ^ (b & c));
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    hash->h_sub[0] += a;
+    hash->h_sub[1] += b;
+    hash->h_sub[2] += c;
+    hash->h_sub[3] += d;
+    hash->h_sub[4] += e;
+    hash->h_sub[5] += f;
+    hash->h_sub[6] += g;
+    hash->h_sub[7] += h;
+
+}		/* -----  end of static function compute_hash  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha256_init
+ *  Description:  API function to prepare hash for a new msg.
+ * ==============================================================
+ */
+void
+sha256_init(struct sha256_s *hash)
+{
+    memcpy(hash->h_sub, h_init, sizeof(h_init));
+    hash->msg_idx = 0;
+    hash->length  = 0;
+}		/* -----  end of function sha256_init  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha256_update
+ *  Description:  API function to add len bytes, pointed to by
+ *                buf, to the msg being hashed.  As in
+ *                sha_hash_update( ), full blocks are compressed
+ *                in place and only a partial block is copied.
+ * ==============================================================
+ */
+void
+sha256_update(struct sha256_s *hash, const uint8 *buf, size_t len)
+{
+    uint64 start = STATS_CLOCK();
+    size_t n;
+
+    hash->length += len;
+
+    if (hash->msg_idx > 0) {
+        n = BLK_SIZE - hash->msg_idx;
+        if (n > len)
+            n = len;
+
+        memcpy(hash->msg_block + hash->msg_idx, buf, n);
+        hash->msg_idx += n;
+        buf += n;
+        len -= n;
+
+        if (hash->msg_idx < BLK_SIZE)
+            return;
+
+        compute_hash(hash, hash->msg_block);
+        hash->msg_idx = 0;
+    }
+
+    while (len >= BLK_SIZE) {
+        compute_hash(hash, buf);
+        buf += BLK_SIZE;
+        len -= BLK_SIZE;
+    }
+
+    memcpy(hash->msg_block, buf, len);
+    hash->msg_idx = len;
+
+    STATS_ADD(stage_ns[STAGE_COMPRESS], STATS_CLOCK() - start);
+
+}		/* -----  end of function sha256_update  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  sha256_final
+ *  Description:  API function to pad the msg, exactly as for
+ *                SHA-1, and copy the 256-bit msg digest, most
+ *                significant byte first, into digest, which must
+ *                be at least SHA256_DIGEST_SIZE bytes in length.
+ * ==============================================================
+ */
+void
+sha256_final(struct sha256_s *hash, uint8 *digest)
+{
+    uint64 bits = hash->length * 8;
+    int i;
+
+    hash->msg_block[hash->msg_idx++] = 0x80;
+
+    /* no room left for the length: it goes in an extra block */
+    if (hash->msg_idx > BLK_SIZE - 8) {
+        memset(hash->msg_block + hash->msg_idx, 0, BLK_SIZE - hash->msg_idx);
+        compute_hash(hash, hash->msg_block);
+        hash->msg_idx = 0;
+    }
+
+    memset(hash->msg_block + hash->msg_idx, 0, BLK_SIZE - 8 - hash->msg_idx);
+
+    for (i = 0; i < 8; i++)
+        hash->msg_block[BLK_SIZE - 1 - i] = (uint8) (bits >> (i * 8));
+
+    compute_hash(hash, hash->msg_block);
+
+    for (i = 0; i < 8; i++) {
+        digest[i*4 + 0] = (uint8) (hash->h_sub[i] >> 24);
+        digest[i*4 + 1] = (uint8) (hash->h_sub[i] >> 16);
+        digest[i*4 + 2] = (uint8) (hash->h_sub[i] >>  8);
+        digest[i*4 + 3] = (uint8)  hash->h_sub[i];
+    }
+}		/* -----  end of function sha256_final  ----- */
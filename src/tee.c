@@ -0,0 +1,199 @@
+/*
+ * ==============================================================
+ *       Filename:  tee.c
+ *
+ *    Description:  Pass-through hashing: copies an input to an
+ *                  output and computes the SHA-1 msg digest of the
+ *                  bytes on the way, from the same buffers, so the
+ *                  data is only read once.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *  This program is free software: you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version
+ *  3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be
+ *  useful, but WITHOUT ANY WARRANTY; without even the implied
+ *  warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public
+ *  License along with this program.  If not, see
+ *  <http://www.gnu.org/licenses/>.
+ *
+ * ==============================================================
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "tee.h"
+#include "pipeline.h"
+#include "stats.h"
+
+
+#define TEE_BUF_SIZE  (64 * 1024)  /* read size without a pipeline */
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  write_all
+ *  Description:  Writes all len bytes of buf to fd, carrying on
+ *                after short writes and interrupted calls.
+ *                Returns 0 on success or -1 on a write error.
+ * ==============================================================
+ */
+static int
+write_all(int fd, const uint8 *buf, size_t len)
+{
+    ssize_t n;
+
+    while (len > 0) {
+        n = write(fd, buf, len);
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        buf += n;
+        len -= n;
+    }
+
+    return 0;
+}		/* -----  end of static function write_all  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  same_file
+ *  Description:  Returns non-zero if fd_a and fd_b are open on
+ *                the same file, which copying onto would
+ *                truncate before it was read.
+ * ==============================================================
+ */
+static int
+same_file(int fd_a, int fd_b)
+{
+    struct stat a, b;
+
+    if (fstat(fd_a, &a) != 0 || fstat(fd_b, &b) != 0)
+        return 0;
+
+    return S_ISREG(a.st_mode) && a.st_dev == b.st_dev
+                              && a.st_ino == b.st_ino;
+}		/* -----  end of static function same_file  ----- */
+
+
+
+/*
+ * ===  FUNCTION  ===============================================
+ *         Name:  tee_file
+ *  Description:  API function to copy the file given by src (or
+ *                stdin if src is NULL) to the file given by dst
+ *                (or stdout if dst is NULL, created or truncated
+ *                otherwise), storing the digest of the copied
+ *                bytes in digest.
+ *
+ *                The input is read by a pipeline_s, so reading the
+ *                next buffer overlaps hashing and writing this
+ *                one; each buffer is hashed while it is still in
+ *                cache from being read and then written out.  If
+ *                the pipeline can't be started, the input is read
+ *                here, TEE_BUF_SIZE bytes at a time.
+ *
+ *                Returns 0 on success or -1 on failure, after
+ *                printing the reason to stderr.
+ * ==============================================================
+ */
+int
+tee_file(char *src, char *dst, uint8 *digest)
+{
+    struct sha_hash_s hash;
+    struct pipeline_s pl;
+    struct stat st;
+    uint8 local[TEE_BUF_SIZE];
+    const uint8 *buf = local;
+    ssize_t n;
+    int in  = STDIN_FILENO;
+    int out = STDOUT_FILENO;
+    int ret = -1;
+    int sync;
+
+    const char *src_name = src ? src : "-";
+    const char *dst_name = dst ? dst : "-";
+
+    if (src && (in = open(src, O_RDONLY)) < 0) {
+        fprintf(stderr, "couldn't open file '%s'\n", src);
+        return -1;
+    }
+
+    /* truncated only once it is known not to be src */
+    if (dst && (out = open(dst, O_WRONLY | O_CREAT, 0666)) < 0) {
+        fprintf(stderr, "couldn't create file '%s'\n", dst);
+        goto close_in;
+    }
+
+    if (same_file(in, out)) {
+        fprintf(stderr, "'%s' and '%s' are the same file\n",
+                src_name, dst_name);
+        goto close_out;
+    }
+
+    if (dst && fstat(out, &st) == 0 && S_ISREG(st.st_mode)
+            && ftruncate(out, 0) != 0) {
+        fprintf(stderr, "couldn't truncate file '%s'\n", dst);
+        goto close_out;
+    }
+
+    sync = pipeline_start(&pl, in, NULL) != 0;
+
+    sha_hash_init(&hash);
+
+    while ((n = sync ? stats_read(in, local, sizeof(local))
+                     : pipeline_next(&pl, &buf)) > 0) {
+        sha_hash_update(&hash, buf, n);
+
+        if (write_all(out, buf, n) != 0) {
+            fprintf(stderr, "error writing '%s': %s\n", dst_name,
+                    strerror(errno));
+            break;
+        }
+    }
+
+    if (!sync)
+        pipeline_finish(&pl);
+
+    if (n < 0)
+        fprintf(stderr, "error reading '%s'\n", src_name);
+
+    if (n == 0) {
+        sha_hash_final(&hash, digest);
+        ret = 0;
+    }
+
+close_out:
+    if (dst && close(out) != 0 && ret == 0) {
+        fprintf(stderr, "error writing '%s': %s\n", dst_name, strerror(errno));
+        ret = -1;
+    }
+
+close_in:
+    if (src)
+        close(in);
+
+    return ret;
+}		/* -----  end of function tee_file  ----- */
@@ -0,0 +1,74 @@
+#!/bin/bash
+#================================================================
+#
+#          FILE:  engine_test.sh
+#
+#         USAGE:  test/engine_test.sh [SHA1]
+#
+#   DESCRIPTION:  Differential test of the compression engines.
+#                 Every engine SHA1 lists must agree with the
+#                 generic one, and the generic one with sha1sum,
+#                 for whole files and for pieces hashed several at
+#                 a time (which goes through an engine's x4 kernel
+#                 when it has one).
+#
+#       OPTIONS:  SHA1 is the command to run, ./sha1 by default.
+#                 It is split on spaces, so an emulator can be put
+#                 in front of a cross-built binary; see
+#                 make check-aarch64.
+#  REQUIREMENTS:  sha1sum
+#
+#       VERSION:  1.0
+#       CREATED:  10/18/2026
+#      REVISION:  ---
+#================================================================
+
+sha1=${1:-./sha1}
+
+echo ""
+echo "*** Compression engines (sha1 --engine) ***"
+echo ""
+echo "Every engine this CPU supports must agree with the generic one,"
+echo "for whole files and for pieces hashed several at a time."
+echo "=================================================================="
+
+enginedir=$(mktemp -d)
+for len in 0 1 55 56 63 64 65 127 128 1000 65536 100000;
+do
+    head -c $len /dev/urandom > $enginedir/$len.bin
+done
+head -c 300000 /dev/urandom > $enginedir/pieces.bin
+
+echo -n "engine generic against sha1sum  -->  "
+result=ok
+for file in $enginedir/*.bin;
+do
+    if [ "$($sha1 --engine generic $file | cut -c1-40)" != \
+         "$(sha1sum $file | cut -c1-40)" ] ; then
+        result="MISMATCH ($file)"
+    fi
+done
+echo "$result"
+
+for engine in $($sha1 --list-engines);
+do
+    echo -n "engine $engine  -->  "
+
+    result=ok
+    for file in $enginedir/*.bin;
+    do
+        if [ "$($sha1 --engine $engine $file)" != \
+             "$($sha1 --engine generic $file)" ] ; then
+            result="MISMATCH ($file)"
+        fi
+    done
+
+    if [ "$($sha1 --engine $engine -p --piece-size 16K $enginedir/pieces.bin)" != \
+         "$($sha1 --engine generic -p --piece-size 16K $enginedir/pieces.bin)" ] ; then
+        result="MISMATCH (pieces)"
+    fi
+
+    echo "$result"
+done
+
+rm -rf $enginedir
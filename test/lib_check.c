@@ -0,0 +1,96 @@
+/*
+ * ==============================================================
+ *       Filename:  lib_check.c
+ *
+ *    Description:  Links against libsha1 through libsha1.h only and
+ *                  prints each file's digest the way sha1sum does,
+ *                  for test/sha_test.sh to compare.  Every file is
+ *                  hashed three ways (sha1_file( ), sha1_update( )
+ *                  in odd sized pieces and sha1_digest( )); if they
+ *                  disagree the line says so instead.  With -e, it
+ *                  prints sha1_engine( ) instead.  It also defines
+ *                  functions named like the library's internals,
+ *                  which must not clash with them.
+ *
+ *        Version:  1.0
+ *        Created:  10/18/2026
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ * ==============================================================
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "libsha1.h"
+
+
+/* the same names as functions inside the library, which a program
+ * linked against libsha1.a must be free to use */
+int engine_get(void)      { return 0; }
+int stats_read(void)      { return 0; }
+int pipeline_start(void)  { return 0; }
+
+
+int
+main(int argc, char *argv[])
+{
+    unsigned char whole[SHA1_DIGEST_SIZE], pieces[SHA1_DIGEST_SIZE];
+    unsigned char once[SHA1_DIGEST_SIZE];
+    static unsigned char buf[1 << 20];
+    sha1_ctx *ctx;
+    size_t len, off, n;
+    FILE  *in;
+    int    i, j;
+
+    if (sha1_abi_version() != SHA1_ABI_VERSION) {
+        fprintf(stderr, "built for ABI %d, got %u\n", SHA1_ABI_VERSION,
+                sha1_abi_version());
+        return EXIT_FAILURE;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "-e") == 0) {
+        printf("%s\n", sha1_engine());
+        return EXIT_SUCCESS;
+    }
+
+    if ((ctx = sha1_new()) == NULL)
+        return EXIT_FAILURE;
+
+    for (i = 1; i < argc; i++) {
+
+        if (sha1_file(argv[i], whole) != 0
+                || (in = fopen(argv[i], "rb")) == NULL) {
+            printf("unreadable  %s\n", argv[i]);
+            continue;
+        }
+
+        len = fread(buf, 1, sizeof(buf), in);
+        fclose(in);
+
+        sha1_reset(ctx);
+        for (off = 0, n = 1; off < len; off += n, n = n * 3 + 1) {
+            if (n > len - off)
+                n = len - off;
+            sha1_update(ctx, buf + off, n);
+        }
+        sha1_final(ctx, pieces);
+
+        sha1_digest(buf, len, once);
+
+        if (memcmp(whole, pieces, sizeof(whole)) != 0
+                || memcmp(whole, once, sizeof(whole)) != 0) {
+            printf("disagree  %s\n", argv[i]);
+            continue;
+        }
+
+        for (j = 0; j < SHA1_DIGEST_SIZE; j++)
+            printf("%02x", whole[j]);
+        printf("  %s\n", argv[i]);
+    }
+
+    sha1_free(ctx);
+
+    return EXIT_SUCCESS;
+}
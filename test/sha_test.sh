@@ -63,3 +63,599 @@ do
 
     echo ""
 done
+
+
+echo ""
+echo "*** Content-defined chunks (sha1 --chunk) ***"
+echo ""
+echo "Each chunk's digest is compared with sha1sum run over the same"
+echo "byte range of the file."
+echo "=================================================================="
+
+for file in test/*.txt;
+do
+    ./sha1 --chunk --min-size 64 --avg-size 256 --max-size 1K $file |
+    while read offset length digest name;
+    do
+        echo -n "chunk $offset+$length of $name  -->  "
+
+        if [ ! -z $syssha1 ] ; then
+            expect=$(tail -c +$((offset + 1)) $name | head -c $length |
+                     $syssha1 | cut -c1-40)
+            if [ "$digest" = "$expect" ] ; then
+                echo "ok"
+            else
+                echo "MISMATCH ($digest != $expect)"
+            fi
+        else
+            echo "$digest"
+        fi
+    done
+done
+
+echo ""
+echo "Every chunk but the last must be min-size to max-size bytes long,"
+echo "and the chunks must cover the file."
+echo "=================================================================="
+
+chunkfile=$(mktemp)
+head -c 200000 /dev/urandom > $chunkfile
+
+for sizes in "64 256 1024" "1024 1024 1024" "100 4096 4096" ;
+do
+    set -- $sizes
+    echo -n "chunk sizes min $1 avg $2 max $3  -->  "
+    ./sha1 --chunk --min-size $1 --avg-size $2 --max-size $3 $chunkfile |
+    awk -v min=$1 -v max=$3 -v size=$(stat -c %s $chunkfile) '
+        { if (NR > 1 && (last < min || last > max)) bad = 1
+          if ($1 != total) bad = 1
+          last = $2; total += $2 }
+        END { if (last < 1 || last > max || total != size) bad = 1
+              print bad ? "MISMATCH" : "ok" }'
+done
+
+# an unreadable file fails on its own, the rest of the run goes on
+echo -n "chunk past a missing file  -->  "
+out=$(./sha1 --chunk $chunkfile.missing $chunkfile 2>/dev/null)
+status=$?
+if [ $status -eq 1 ] && [ "$out" = "$(./sha1 --chunk $chunkfile)" ] ; then
+    echo "ok"
+else
+    echo "MISMATCH ($status)"
+fi
+
+# sizes past 4G, or past 64 bits once the suffix is applied, are refused
+for max in 5G 17179869184G 18446744073709551616 -1 ; do
+    echo -n "chunk max size $max refused  -->  "
+    if ./sha1 --chunk --max-size $max $chunkfile >/dev/null 2>&1 ; then
+        echo "MISMATCH"
+    else
+        echo "ok"
+    fi
+done
+
+rm -f $chunkfile
+
+
+echo ""
+echo "*** Fixed size pieces (sha1 --pieces) ***"
+echo ""
+echo "A file made of repeated copies of the test files is split into"
+echo "16K pieces; each piece and the whole file are compared with"
+echo "sha1sum, and the list must not depend on the number of threads."
+echo "=================================================================="
+
+piecefile=$(mktemp)
+for i in $(seq 1 100);
+do
+    cat test/*.txt >> $piecefile
+done
+
+./sha1 --pieces --piece-size 16K --threads 4 $piecefile |
+while read offset length digest name;
+do
+    # the last line is the whole-file digest: 'digest  file'
+    if [ -z "$digest" ] ; then
+        echo -n "whole file  -->  "
+        expect=$($syssha1 $piecefile | cut -c1-40)
+        digest=$offset
+    else
+        echo -n "piece $offset+$length  -->  "
+        expect=$(tail -c +$((offset + 1)) $piecefile | head -c $length |
+                 $syssha1 | cut -c1-40)
+    fi
+
+    if [ "$digest" = "$expect" ] ; then
+        echo "ok"
+    else
+        echo "MISMATCH ($digest != $expect)"
+    fi
+done
+
+echo -n "pieces past a missing file  -->  "
+out=$(./sha1 -p --piece-size 16K $piecefile.missing $piecefile 2>/dev/null)
+status=$?
+if [ $status -eq 1 ] \
+        && [ "$out" = "$(./sha1 -p --piece-size 16K $piecefile)" ] ; then
+    echo "ok"
+else
+    echo "MISMATCH ($status)"
+fi
+
+echo -n "1 thread vs 4 threads  -->  "
+if [ "$(./sha1 -p --piece-size 16K -t 1 $piecefile)" = \
+     "$(./sha1 -p --piece-size 16K -t 4 $piecefile)" ] ; then
+    echo "ok"
+else
+    echo "MISMATCH"
+fi
+
+rm -f $piecefile
+
+
+echo ""
+echo "*** Git blob object ids (sha1 --git-blob) ***"
+echo ""
+echo "'git hash-object' is used as the reference when it is installed;"
+echo "the file names are also fed to --batch on stdin."
+echo "=================================================================="
+
+sysgit=$(which git)
+
+ls test/*.txt | ./sha1 --git-blob --batch |
+while read digest name;
+do
+    echo -n "blob $name  -->  "
+
+    if [ ! -z $sysgit ] ; then
+        expect=$($sysgit hash-object $name)
+        if [ "$digest" = "$expect" ] ; then
+            echo "ok"
+        else
+            echo "MISMATCH ($digest != $expect)"
+        fi
+    else
+        echo "$digest"
+    fi
+done
+
+
+echo ""
+echo "*** Statistics (sha1 --stats) ***"
+echo ""
+echo "The JSON report's bytes_read must match the size of each file."
+echo "=================================================================="
+
+for file in test/*.txt;
+do
+    echo -n "stats $file  -->  "
+
+    size=$(wc -c < $file)
+    report=$(./sha1 --stats $file 2>&1 >/dev/null)
+
+    if echo "$report" | grep -q "\"bytes_read\": $size," ; then
+        echo "ok"
+    else
+        echo "MISMATCH ($report)"
+    fi
+done
+
+
+echo ""
+echo "*** Hashing daemon (sha1 --server / --client) ***"
+echo ""
+echo "A daemon is started on a temporary socket; each file is sent to"
+echo "it by path and, through stdin, inline."
+echo "=================================================================="
+
+sockdir=$(mktemp -d)
+./sha1 --server $sockdir/sha1.sock --threads 2 &
+serverpid=$!
+
+# wait for the socket to show up
+for i in $(seq 1 50);
+do
+    [ -S $sockdir/sha1.sock ] && break
+    sleep 0.1
+done
+
+for file in test/*.txt;
+do
+    expect=$(./sha1 $file | cut -c1-40)
+
+    echo -n "client path   $file  -->  "
+    digest=$(./sha1 --client $sockdir/sha1.sock $file | cut -c1-40)
+    [ "$digest" = "$expect" ] && echo "ok" || echo "MISMATCH ($digest)"
+
+    echo -n "client inline $file  -->  "
+    digest=$(./sha1 --client $sockdir/sha1.sock < $file | cut -c1-40)
+    [ "$digest" = "$expect" ] && echo "ok" || echo "MISMATCH ($digest)"
+done
+
+# a FIFO nobody writes to must be refused, not block a worker
+mkfifo $sockdir/fifo
+echo -n "client path   FIFO refused  -->  "
+if timeout 5 ./sha1 --client $sockdir/sha1.sock $sockdir/fifo 2>&1 |
+        grep -q "not a regular file" ; then
+    echo "ok"
+else
+    echo "MISMATCH"
+fi
+
+# a client that pipelines requests and never reads the replies must
+# be dropped, not stall the workers every other client shares
+echo -n "client ignoring its replies dropped  -->  "
+if command -v perl >/dev/null ; then
+    perl -MSocket -e '
+        $SIG{PIPE} = "IGNORE";
+        socket(S, PF_UNIX, SOCK_STREAM, 0) && connect(S, sockaddr_un($ARGV[0]))
+            or die;
+        $f = pack("NNC", 6, 1, ord("B")) . "x";
+        for (1 .. 500000) { last unless defined send(S, $f, 0) }
+        sleep 10;' $sockdir/sha1.sock &
+    stallpid=$!
+    sleep 2
+    digest=$(timeout 5 ./sha1 --client $sockdir/sha1.sock test/lorem_ipsum.txt)
+    kill $stallpid
+    wait $stallpid 2>/dev/null
+    [ "$digest" = "$(./sha1 test/lorem_ipsum.txt)" ] && echo "ok" ||
+        echo "MISMATCH ($digest)"
+else
+    echo "skipped (no perl)"
+fi
+
+# a second server must neither take over the live socket nor remove
+# a file that isn't a socket
+echo -n "server on a live socket refused  -->  "
+if ! timeout 5 ./sha1 --server $sockdir/sha1.sock 2>/dev/null \
+        && [ -n "$(./sha1 --client $sockdir/sha1.sock test/lorem_ipsum.txt)" ]
+then
+    echo "ok"
+else
+    echo "MISMATCH"
+fi
+
+echo precious > $sockdir/precious.txt
+echo -n "server on a regular file refused  -->  "
+if ! timeout 5 ./sha1 --server $sockdir/precious.txt 2>/dev/null \
+        && [ "$(cat $sockdir/precious.txt)" = "precious" ] ; then
+    echo "ok"
+else
+    echo "MISMATCH"
+fi
+
+kill $serverpid
+wait $serverpid 2>/dev/null
+rm -rf $sockdir
+
+
+test/engine_test.sh ./sha1
+
+
+echo ""
+echo "*** Piped input ***"
+echo ""
+echo "Input from a pipe is read by a separate thread while it is being"
+echo "hashed; the digest must match that of the same bytes in a file."
+echo "=================================================================="
+
+pipedir=$(mktemp -d)
+for len in 0 1 64 1048575 1048576 1048577 5000000;
+do
+    head -c $len /dev/urandom > $pipedir/$len.bin
+done
+
+for file in $pipedir/*.bin;
+do
+    echo -n "pipe $(basename $file)  -->  "
+
+    expect=$(./sha1 < $file)
+    digest=$(cat $file | ./sha1)
+    [ "$digest" = "$expect" ] && echo "ok" || echo "MISMATCH ($digest)"
+done
+
+rm -rf $pipedir
+
+
+echo ""
+echo "*** Tee mode (sha1 --tee) ***"
+echo ""
+echo "The copy must be identical to the input and the digest, printed"
+echo "to stderr or the --sidecar file, must match the normal mode."
+echo "=================================================================="
+
+teedir=$(mktemp -d)
+head -c 3000000 /dev/urandom > $teedir/in.bin
+
+for file in test/*.txt $teedir/in.bin;
+do
+    expect=$(./sha1 < $file | cut -c1-40)
+
+    echo -n "tee stdin  $(basename $file)  -->  "
+    digest=$(cat $file | ./sha1 --tee 2>&1 >$teedir/out | cut -c1-40)
+    if cmp -s $file $teedir/out && [ "$digest" = "$expect" ] ; then
+        echo "ok"
+    else
+        echo "MISMATCH ($digest)"
+    fi
+
+    echo -n "tee file   $(basename $file)  -->  "
+    ./sha1 --tee --sidecar $teedir/out.sha1 $file $teedir/out
+    digest=$(cut -c1-40 $teedir/out.sha1)
+    if cmp -s $file $teedir/out && [ "$digest" = "$expect" ] ; then
+        echo "ok"
+    else
+        echo "MISMATCH ($digest)"
+    fi
+done
+
+# a slow producer's bytes must come through before the pipe ends
+echo -n "tee slow producer passes bytes on  -->  "
+(printf abc; sleep 3) | timeout 1 ./sha1 --tee > $teedir/out 2>/dev/null
+[ "$(cat $teedir/out)" = "abc" ] && echo "ok" || echo "MISMATCH"
+
+# a write error must not wait for the producer to finish
+echo -n "tee write error with stalled producer  -->  "
+(printf abc; sleep 3) | timeout 1 ./sha1 --tee - /dev/full 2>/dev/null
+[ $? -eq 1 ] && echo "ok" || echo "MISMATCH"
+
+rm -rf $teedir
+
+
+echo ""
+echo "*** Several algorithms in one pass (sha1 --algo) ***"
+echo ""
+echo "Each 'ALGO (file) = digest' line must match sha1sum/sha256sum"
+echo "--tag, with the algorithms sharing a thread and on their own."
+echo "=================================================================="
+
+algodir=$(mktemp -d)
+for len in 0 55 56 64 1000 3000000;
+do
+    head -c $len /dev/urandom > $algodir/$len.bin
+done
+
+for file in test/*.txt $algodir/*.bin;
+do
+    expect="$(sha1sum --tag $file)
+$(sha256sum --tag $file)"
+
+    for threads in 1 2;
+    do
+        echo -n "algo -t $threads $(basename $file)  -->  "
+        digest=$(./sha1 --algo sha1,sha256 -t $threads $file)
+        [ "$digest" = "$expect" ] && echo "ok" || echo "MISMATCH ($digest)"
+    done
+done
+
+rm -rf $algodir
+
+
+echo ""
+echo "*** Collision detection (sha1 --detect-collisions) ***"
+echo ""
+echo "Ordinary files must hash as with sha1sum and not be flagged."
+echo "=================================================================="
+
+for file in test/*.txt;
+do
+    expect=$(sha1sum $file)
+    echo -n "detect $(basename $file)  -->  "
+    digest=$(./sha1 --detect-collisions $file 2>&1)
+    if [ $? -eq 0 ] && [ "$digest" = "$expect" ] ; then
+        echo "ok"
+    else
+        echo "MISMATCH ($digest)"
+    fi
+done
+
+echo ""
+echo "The first 320 bytes of the two SHAttered PDFs collide and must be"
+echo "flagged, with the SHA-1DC safe hash (the attack block compressed"
+echo "three times) printed as their digest."
+echo "=================================================================="
+
+for pair in "1 7117b3cb9225aaf0d8ef1a40e493957b0bf8693d" \
+            "2 29f38ae9fd98e2931120fa0bf213e024250d3f6a";
+do
+    set -- $pair
+    file=test/shattered-$1.bin
+    echo -n "detect $(basename $file)  -->  "
+    plain=$(./sha1 $file)
+    digest=$(./sha1 --detect-collisions $file 2>/dev/null)
+    status=$?
+    if [ "$plain" = "f92d74e3874587aaf443d1db961d4e26dde13e9c  $file" ] \
+            && [ $status -eq 1 ] && [ "$digest" = "$2  $file" ] ; then
+        echo "ok"
+    else
+        echo "MISMATCH ($status $digest)"
+    fi
+done
+
+
+echo ""
+echo "*** File lists (sha1 --files-from / --files0-from) ***"
+echo ""
+echo "Names with spaces come through --files0-from; a missing file is"
+echo "reported without stopping the others, and fails the run."
+echo "=================================================================="
+
+listdir=$(mktemp -d)
+for len in 0 1 64 131072 131073;
+do
+    head -c $len /dev/urandom > "$listdir/file $len"
+done
+
+sha1=$(pwd)/sha1
+expect=$(cd $listdir && sha1sum file*)
+digest=$(cd $listdir && printf '%s\0' file* | $sha1 --files0-from -)
+
+echo -n "files0-from  -->  "
+[ "$digest" = "$expect" ] && echo "ok" || echo "MISMATCH ($digest)"
+
+ls test/*.txt > $listdir/list
+echo "$listdir/missing" >> $listdir/list
+
+echo -n "files-from with a missing file  -->  "
+digest=$(./sha1 --files-from $listdir/list 2>/dev/null)
+status=$?
+if [ $status -ne 0 ] && [ "$digest" = "$(sha1sum test/*.txt)" ] ; then
+    echo "ok"
+else
+    echo "MISMATCH ($digest)"
+fi
+
+# a "-" read from stdin can't mean stdin: that is the list itself
+echo -n "batch with a - entry  -->  "
+files="test/lorem_ipsum.txt test/sha_spec_example1.txt"
+digest=$(printf '%s\n' test/lorem_ipsum.txt - test/sha_spec_example1.txt |
+         ./sha1 --batch 2>/dev/null)
+status=$?
+if [ $status -eq 1 ] && [ "$digest" = "$(sha1sum $files)" ] ; then
+    echo "ok"
+else
+    echo "MISMATCH ($status $digest)"
+fi
+
+# the directory is replaced while the run is in another one, so its
+# cached descriptor must not be used when the run comes back to it
+mkdir $listdir/dir $listdir/other
+echo one > $listdir/dir/a
+echo three > $listdir/other/b
+
+echo -n "files-from with a replaced directory  -->  "
+digest=$( (echo $listdir/dir/a; echo $listdir/other/b; sleep 1;
+           mv $listdir/dir $listdir/old; mkdir $listdir/dir;
+           echo two > $listdir/dir/a; echo $listdir/dir/a) |
+         ./sha1 --files-from - | cut -d' ' -f1 | tr '\n' ' ')
+expect=$( (echo one; echo three; echo two) | while read line; do
+             echo $line | sha1sum | cut -d' ' -f1; done | tr '\n' ' ')
+[ "$digest" = "$expect" ] && echo "ok" || echo "MISMATCH ($digest)"
+
+rm -rf $listdir
+
+
+echo ""
+echo "*** Incremental hashing of appended files (sha1 --incremental) ***"
+echo ""
+echo "Each digest must match sha1sum; after an append only the new bytes"
+echo "may be read, and a rewritten or truncated file is hashed again."
+echo "=================================================================="
+
+incrdir=$(mktemp -d)
+log=$incrdir/log
+head -c 100000 /dev/urandom > $log
+
+check_incr()
+{
+    echo -n "incremental $1  -->  "
+    digest=$(./sha1 --stats --incremental $log 2>$incrdir/stats)
+    read=$(sed 's/.*"bytes_read": \([0-9]*\).*/\1/' $incrdir/stats)
+    if [ "$digest" = "$(sha1sum $log)" ] && [ "$read" = "$2" ] ; then
+        echo "ok"
+    else
+        echo "MISMATCH ($digest, read $read)"
+    fi
+}
+
+check_incr "first run" 100000
+head -c 777 /dev/urandom >> $log
+check_incr "append" 777
+check_incr "no change" 0
+printf 'x' | dd of=$log bs=1 seek=100500 conv=notrunc 2>/dev/null
+echo tail >> $log
+check_incr "rewritten" $(stat -c %s $log)
+truncate -s 5000 $log
+check_incr "truncated" 5000
+head -c 100000 /dev/urandom >> $log
+check_incr "append after truncate" 100000
+printf 'xyzzy' | dd of=$log bs=1 seek=10 conv=notrunc 2>/dev/null
+echo head >> $log
+check_incr "head rewritten" $(stat -c %s $log)
+printf 'xyzzy' | dd of=$log bs=1 seek=50000 conv=notrunc 2>/dev/null
+check_incr "rewritten in place" $(stat -c %s $log)
+
+# the head and tail checks go through neither the engine nor --stats:
+# an unchanged file only compresses its padding block
+echo -n "incremental checks not counted  -->  "
+./sha1 --stats --incremental $log >/dev/null 2>$incrdir/stats
+blocks=$(sed 's/.*"blocks_compressed": \([0-9]*\).*/\1/' $incrdir/stats)
+if [ "$blocks" = 1 ] ; then
+    echo "ok"
+else
+    echo "MISMATCH (blocks $blocks)"
+fi
+
+# a state is only resumed by the engine that saved it, and an attack
+# block hashed in an earlier run is still reported after an append
+check_incr_dc()
+{
+    echo -n "incremental $1  -->  "
+    digest=$(./sha1 --stats --incremental --detect-collisions $log \
+             2>$incrdir/stats)
+    status=$?
+    read=$(sed -n 's/.*"bytes_read": \([0-9]*\).*/\1/p' $incrdir/stats)
+    expect=$(./sha1 --detect-collisions $log 2>/dev/null)
+    if [ $status -eq 1 ] && [ "$digest" = "$expect" ] \
+            && [ "$read" = "$2" ] ; then
+        echo "ok"
+    else
+        echo "MISMATCH ($status $digest, read $read)"
+    fi
+}
+
+cp test/shattered-1.bin $log
+check_incr "plain shattered" 320
+check_incr_dc "detect after plain" 320
+head -c 1000 /dev/urandom >> $log
+check_incr_dc "detect after append" 1000
+check_incr "plain after detect" 1320
+
+rm -rf $incrdir
+
+
+echo ""
+echo "*** The shared and static library (make lib) ***"
+echo ""
+echo "Only the libsha1.h API may be exported, even from libsha1.a, and"
+echo "a program linked against either library must get the same digests"
+echo "as sha1sum, with sha1_engine( ) naming the kernel the library bound."
+echo "=================================================================="
+
+libdir=$(mktemp -d)
+head -c 300000 /dev/urandom > $libdir/random
+
+echo -n "exported symbols  -->  "
+if make -s lib >/dev/null 2>&1 ; then
+    exported=$(nm -D --defined-only libsha1.so | awk '$2 == "T" { print $3 }' \
+               | grep -v '^sha1_[a-z_]*@@SHA1_1\.0$')
+    exported="$exported$(nm -g --defined-only libsha1.a \
+               | awk 'NF == 3 { print $3 }' | grep -v '^sha1_[a-z_]*$')"
+    if [ -z "$exported" ] ; then
+        echo "ok"
+    else
+        echo "MISMATCH ($exported)"
+    fi
+else
+    echo "MISMATCH (make lib failed)"
+fi
+
+for link in shared static ; do
+    echo -n "$link library  -->  "
+    if [ $link = shared ] ; then
+        gcc -Iinclude -o $libdir/check test/lib_check.c -L. -lsha1 \
+            -Wl,-rpath,$(pwd)
+    else
+        gcc -Iinclude -o $libdir/check test/lib_check.c libsha1.a -lpthread
+    fi
+    files="test/sha_spec_example1.txt test/lorem_ipsum.txt $libdir/random"
+    engine=$(./sha1 --list-engines | grep -x armv8-ce || echo generic)
+    if [ "$($libdir/check $files)" = "$(sha1sum $files)" ] \
+            && [ "$($libdir/check -e)" = "$engine" ] ; then
+        echo "ok"
+    else
+        echo "MISMATCH"
+    fi
+done
+
+rm -rf $libdir